@@ -10,7 +10,13 @@ TESTS = [
     (['bin/tp2', '--start', '1,0,0', '--end', '0,1,a', '--input-filename', 'data/map.json', '--output-format', 'png'], 'Error: the coordinates must be integers separated by commas', 2),
     (['bin/tp2', '--input-filename', 'data/map.json', '--output-format', 'png'], 'Error: output filename is mandatory with png format', 3),
     (['bin/tp2', '--input-filename', 'data/map.json', '--strat'], None, 4),
+    (['bin/tp2', '--input-filename', 'data/map.json', '--output-format', 'flowfield'], 'Error: output filename is mandatory with flowfield format', 3),
     (['bin/tp2', '--output-format jpeg'], 'Error: input filename is mandatory', 5),
+    (['bin/tp2', '--algorithm', 'dfs', '--input-filename', 'data/map.json'], 'Error: algorithm dfs not supported', 7),
+    (['bin/tp2', '--queries', 'data/missing-queries.txt', '--input-filename', 'data/map.json'], 'Error: invalid queries file', 8),
+    (['bin/tp2', '--threads', '0', '--input-filename', 'data/map.json'], 'Error: the number of threads must be a positive integer', 9),
+    (['bin/tp2', '--cache-size', '-1', '--input-filename', 'data/map.json'], 'Error: the cache size must be a nonnegative integer', 10),
+    (['bin/tp2', '--range', '-2', '--input-filename', 'data/map.json'], 'Error: the range must be a nonnegative integer', 11),
     (['bin/tp2', '--start', '3,0,0', '--end', '9,9,0', '--input-filename', 'data/map.json', '--output-format', 'png', '--output-filename', 'map.png'], 'Error: the cell (9,9,0) does not belong to the map.', 2),
     (['bin/tp2', '--start', '0,9,12', '--end', '0,9,1', '--input-filename', 'data/map.json', '--output-format', 'png', '--output-filename', 'map.png'], 'Error: the cell (0,9,12) does not belong to the map.', 2),
     (['bin/tp2', '--start', '1,0,0', '--end', '1,2,2', '--input-filename', 'data/map3x3error.json', '--output-format', 'png', '--output-filename', 'map3x3.png'], 'Error: Invalid JSON file', 6),
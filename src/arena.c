@@ -0,0 +1,90 @@
+#include <string.h>
+#include "arena.h"
+
+// The number of bytes before the memory of a block, rounded up so that the
+// memory is aligned
+#define ARENA_HEADER_SIZE ((sizeof(struct ArenaBlock) + ARENA_ALIGNMENT - 1) \
+                           & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Allocates a new block.
+ *
+ * @param size  The number of bytes that can be handed out by the block
+ * @return      The block
+ */
+struct ArenaBlock *arena_createBlock(size_t size) {
+    struct ArenaBlock *block =
+        (struct ArenaBlock*)malloc(ARENA_HEADER_SIZE + size);
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+struct Arena arena_create(size_t blockSize) {
+    struct Arena arena;
+    arena.blocks = NULL;
+    arena.blockSize = blockSize > 0 ? blockSize : ARENA_BLOCK_SIZE;
+    arena.numBytes = 0;
+    return arena;
+}
+
+void arena_delete(struct Arena *arena) {
+    while (arena->blocks != NULL) {
+        struct ArenaBlock *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+    arena->numBytes = 0;
+}
+
+void arena_reset(struct Arena *arena) {
+    if (arena->blocks != NULL) {
+        struct ArenaBlock *current = arena->blocks;
+        arena->blocks = current->next;
+        arena_delete(arena);
+        current->next = NULL;
+        current->used = 0;
+        arena->blocks = current;
+    }
+    arena->numBytes = 0;
+}
+
+void *arena_alloc(struct Arena *arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    struct ArenaBlock *block = arena->blocks;
+    if (block == NULL || block->used + size > block->size) {
+        if (size > arena->blockSize / 4) {
+            block = arena_createBlock(size);
+            if (arena->blocks != NULL) {
+                block->next = arena->blocks->next;
+                arena->blocks->next = block;
+            } else {
+                arena->blocks = block;
+            }
+        } else {
+            block = arena_createBlock(arena->blockSize);
+            block->next = arena->blocks;
+            arena->blocks = block;
+        }
+    }
+    void *memory = (char*)block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+    arena->numBytes += size;
+    return memory;
+}
+
+char *arena_strdup(struct Arena *arena, const char *string) {
+    size_t length = strlen(string) + 1;
+    char *copy = (char*)arena_alloc(arena, length);
+    memcpy(copy, string, length);
+    return copy;
+}
@@ -0,0 +1,91 @@
+/**
+ * Module arena
+ *
+ * This module provides an arena (or region) allocator, for the many small
+ * blocks of memory that live exactly as long as a larger structure, such as
+ * the neighbors of the nodes of a map graph or the names of the tiles of a
+ * map.
+ *
+ * An arena hands out memory from large blocks by moving a position forward,
+ * so that an allocation costs a few instructions and no header. The memory
+ * cannot be freed piece by piece: all the blocks of an arena are released at
+ * once by ``arena_delete``, or kept for the next allocations by
+ * ``arena_reset``. A request larger than a quarter of the block size is given
+ * a block of its own, so that little memory is wasted at the end of the
+ * blocks. Every allocation is aligned on ``ARENA_ALIGNMENT`` bytes.
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+
+#define ARENA_BLOCK_SIZE 65536 // The default number of bytes of a block
+#define ARENA_ALIGNMENT 16     // The alignment of every allocation
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct ArenaBlock {          // A block of memory of an arena
+    struct ArenaBlock *next; // The next block (NULL if it is the last one)
+    size_t size;             // The number of bytes that can be handed out
+    size_t used;             // The number of bytes already handed out
+};
+
+struct Arena {                 // An arena
+    struct ArenaBlock *blocks; // The blocks, the current one first (NULL if
+                               // nothing was allocated)
+    size_t blockSize;          // The number of bytes of a block
+    size_t numBytes;           // The number of bytes handed out
+};
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Creates an empty arena.
+ *
+ * No memory is allocated until the first call to ``arena_alloc``.
+ *
+ * @param blockSize  The number of bytes of a block (ARENA_BLOCK_SIZE if 0)
+ * @return           The arena
+ */
+struct Arena arena_create(size_t blockSize);
+
+/**
+ * Deletes the given arena, releasing everything allocated from it.
+ *
+ * The arena is left empty and can be used again.
+ *
+ * @param arena  The arena to delete
+ */
+void arena_delete(struct Arena *arena);
+
+/**
+ * Releases everything allocated from the given arena, but keeps its current
+ * block for the next allocations.
+ *
+ * @param arena  The arena to reset
+ */
+void arena_reset(struct Arena *arena);
+
+/**
+ * Allocates memory from the given arena.
+ *
+ * @param arena  The arena
+ * @param size   The number of bytes
+ * @return       The allocated memory, which is not initialized
+ */
+void *arena_alloc(struct Arena *arena, size_t size);
+
+/**
+ * Returns a copy of a string allocated from the given arena.
+ *
+ * @param arena   The arena
+ * @param string  The string to copy
+ * @return        The copy
+ */
+char *arena_strdup(struct Arena *arena, const char *string);
+
+#endif
@@ -0,0 +1,135 @@
+#include <assert.h>
+#include <string.h>
+#include "flow_field.h"
+#include "map.h"
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Returns the position of a cell in the arrays of a flow field.
+ *
+ * @param field  The flow field
+ * @param cell   The cell
+ * @return       The position of the cell
+ */
+unsigned int flowfield_cellIndex(const struct FlowField *field,
+                                 const struct MapCell *cell) {
+    assert(cell->layer  < field->numLayers);
+    assert(cell->row    < field->numRows);
+    assert(cell->column < field->numColumns);
+    return (cell->layer * field->numRows + cell->row) * field->numColumns
+           + cell->column;
+}
+
+/**
+ * Writes an unsigned 32-bit integer in little-endian order.
+ *
+ * @param outputFile  The file to which the integer is written
+ * @param value       The integer
+ */
+void flowfield_writeInteger(FILE *outputFile, uint32_t value) {
+    unsigned char bytes[4] = {value & 0xff, (value >> 8) & 0xff,
+                              (value >> 16) & 0xff, (value >> 24) & 0xff};
+    fwrite(bytes, 1, 4, outputFile);
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+struct FlowField flowfield_create(struct MapGraphSearch *search,
+                                  const struct MapCell *goal) {
+    const struct MapGraph *graph = search->graph;
+    const struct Map *map = graph->map;
+    struct FlowField field;
+    field.goal = *goal;
+    field.numLayers = map->numLayers;
+    field.numRows = map->numRows;
+    field.numColumns = map->numColumns;
+    unsigned int numCells = field.numLayers * field.numRows * field.numColumns;
+    field.distances = (uint32_t*)malloc(numCells * sizeof(uint32_t));
+    field.directions = (uint8_t*)malloc(numCells * sizeof(uint8_t));
+    for (unsigned int i = 0; i < numCells; ++i) {
+        field.distances[i] = FLOWFIELD_UNREACHABLE;
+    }
+    memset(field.directions, FLOWFIELD_NO_DIRECTION, numCells);
+    mapgraph_searchFrom(search, goal);
+    for (unsigned int i = 0; i < graph->numNodes; ++i) {
+        if (search->generations[i] != search->generation) continue;
+        const struct MapCell *cell = &graph->nodes[i].cell;
+        const struct MapCell *next = &search->predecessors[i]->cell;
+        unsigned int index = flowfield_cellIndex(&field, cell);
+        field.distances[index] = search->distance[i];
+        if (search->distance[i] > 0) {
+            struct Direction direction = {
+                (int)next->row - (int)cell->row,
+                (int)next->column - (int)cell->column,
+                (int)next->layer - (int)cell->layer
+            };
+            field.directions[index] = map_directionBit(&direction);
+        }
+    }
+    return field;
+}
+
+void flowfield_delete(struct FlowField *field) {
+    free(field->distances);
+    free(field->directions);
+    field->distances = NULL;
+    field->directions = NULL;
+}
+
+uint32_t flowfield_distance(const struct FlowField *field,
+                            const struct MapCell *cell) {
+    return field->distances[flowfield_cellIndex(field, cell)];
+}
+
+bool flowfield_nextCell(const struct FlowField *field,
+                        const struct MapCell *cell,
+                        struct MapCell *next) {
+    uint8_t bit = field->directions[flowfield_cellIndex(field, cell)];
+    if (bit == FLOWFIELD_NO_DIRECTION) return false;
+    struct Direction direction = map_bitDirection(bit);
+    next->layer = cell->layer + direction.deltaLayer;
+    next->row = cell->row + direction.deltaRow;
+    next->column = cell->column + direction.deltaColumn;
+    return true;
+}
+
+struct MapGraphPath *flowfield_path(const struct FlowField *field,
+                                    const struct MapCell *start) {
+    uint32_t distance = flowfield_distance(field, start);
+    if (distance == FLOWFIELD_UNREACHABLE) return NULL;
+    struct MapGraphPath *path = mapgraph_createPath(distance + 1);
+    path->cells[0] = *start;
+    for (unsigned int i = 0; i < distance; ++i) {
+        flowfield_nextCell(field, &path->cells[i], &path->cells[i + 1]);
+    }
+    return path;
+}
+
+void flowfield_write(FILE *outputFile, const struct FlowField *field) {
+    unsigned int numCells = field->numLayers * field->numRows * field->numColumns;
+    fwrite("FLOW", 1, 4, outputFile);
+    flowfield_writeInteger(outputFile, field->numLayers);
+    flowfield_writeInteger(outputFile, field->numRows);
+    flowfield_writeInteger(outputFile, field->numColumns);
+    flowfield_writeInteger(outputFile, field->goal.layer);
+    flowfield_writeInteger(outputFile, field->goal.row);
+    flowfield_writeInteger(outputFile, field->goal.column);
+    for (unsigned int i = 0; i < numCells; ++i) {
+        flowfield_writeInteger(outputFile, field->distances[i]);
+    }
+    fwrite(field->directions, 1, numCells, outputFile);
+}
+
+void flowfield_toFile(const struct FlowField *field,
+                      const char *outputFilename) {
+    FILE *outputFile = fopen(outputFilename, "wb");
+    if (outputFile != NULL) {
+        flowfield_write(outputFile, field);
+        fclose(outputFile);
+    }
+}
@@ -0,0 +1,124 @@
+/**
+ * Module flow_field
+ *
+ * This module computes, for a single goal, the distance from every cell of a
+ * map to the goal and the move leading each cell toward the goal.
+ *
+ * When many units head to the same goal, a single breadth-first search from
+ * the goal is enough: since the moves of a map graph can always be done in
+ * both directions, the predecessor of a cell in this search is the next step
+ * of a shortest path from the cell to the goal. A unit standing on any cell
+ * then only has to follow the moves of the field.
+ *
+ * The field covers every cell of every layer, in the order of the flat
+ * indices ``(L * numRows + R) * numColumns + C``. The move of a cell is
+ * stored as the number of its direction (see ``map_directionBit``), so that
+ * the whole field takes five bytes per cell.
+ *
+ * The field can be written as a binary grid, made of the four bytes ``FLOW``,
+ * then the number of layers, rows and columns and the layer, row and column
+ * of the goal, then the distance of every cell and finally the direction of
+ * every cell. The directions are single bytes, while the other numbers are
+ * unsigned 32-bit integers written in little-endian order.
+ */
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "map_graph.h"
+
+#define FLOWFIELD_UNREACHABLE ((uint32_t)-1) // Distance of a cell without path
+                                             // to the goal
+#define FLOWFIELD_NO_DIRECTION 0xff          // Direction of the goal and of
+                                             // the cells without path
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct FlowField {           // A flow field toward a goal
+    struct MapCell goal;     // The goal
+    unsigned int numLayers;  // The number of layers
+    unsigned int numRows;    // The number of rows
+    unsigned int numColumns; // The number of columns
+    uint32_t *distances;     // The distance from each cell to the goal
+    uint8_t *directions;     // The direction of the move of each cell
+};
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Computes the flow field toward the given goal.
+ *
+ * The search is done in the given workspace, whose graph is the graph of the
+ * map. If the goal is not a node of the graph, no cell reaches it.
+ *
+ * @param search  A search workspace on the graph of the map
+ * @param goal    The goal
+ * @return        The flow field
+ */
+struct FlowField flowfield_create(struct MapGraphSearch *search,
+                                  const struct MapCell *goal);
+
+/**
+ * Deletes the given flow field.
+ *
+ * @param field  The flow field to delete
+ */
+void flowfield_delete(struct FlowField *field);
+
+/**
+ * Returns the distance from a cell to the goal of the field.
+ *
+ * @param field  The flow field
+ * @param cell   The cell
+ * @return       The distance, or FLOWFIELD_UNREACHABLE
+ */
+uint32_t flowfield_distance(const struct FlowField *field,
+                            const struct MapCell *cell);
+
+/**
+ * Finds the cell following the given one on a shortest path to the goal.
+ *
+ * @param field  The flow field
+ * @param cell   The cell
+ * @param next   The following cell
+ * @return       False if the cell is the goal or does not reach it
+ */
+bool flowfield_nextCell(const struct FlowField *field,
+                        const struct MapCell *cell,
+                        struct MapCell *next);
+
+/**
+ * Returns the path from a cell to the goal, following the field.
+ *
+ * If the cell does not reach the goal, NULL is returned.
+ *
+ * @param field  The flow field
+ * @param start  The starting cell
+ * @return       A shortest path from the cell to the goal
+ */
+struct MapGraphPath *flowfield_path(const struct FlowField *field,
+                                    const struct MapCell *start);
+
+/**
+ * Writes the flow field as a binary grid.
+ *
+ * @param outputFile  The file to which the field is written
+ * @param field       The flow field
+ */
+void flowfield_write(FILE *outputFile, const struct FlowField *field);
+
+/**
+ * Writes the flow field as a binary grid in a file.
+ *
+ * @param field           The flow field
+ * @param outputFilename  The output filename
+ */
+void flowfield_toFile(const struct FlowField *field,
+                      const char *outputFilename);
+
+#endif
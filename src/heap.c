@@ -0,0 +1,60 @@
+#include "heap.h"
+#include <stdlib.h>
+#include <assert.h>
+
+Heap heap_create(unsigned int capacity) {
+    Heap heap;
+    heap.capacity = capacity > 0 ? capacity : 1;
+    heap.contents =
+        (struct QueueContent*)malloc(heap.capacity * sizeof(struct QueueContent));
+    heap.numNodes = 0;
+    return heap;
+}
+
+void heap_delete(Heap *heap) {
+    free(heap->contents);
+    heap->contents = NULL;
+    heap->numNodes = 0;
+    heap->capacity = 0;
+}
+
+bool heap_isEmpty(const Heap *heap) {
+    return heap->numNodes == 0;
+}
+
+void heap_push(Heap *heap,
+               struct MapCellNode *cell,
+               unsigned int priority) {
+    if (heap->numNodes == heap->capacity) {
+        heap->capacity *= 2;
+        heap->contents = realloc(heap->contents,
+                                 heap->capacity * sizeof(struct QueueContent));
+    }
+    unsigned int i = heap->numNodes;
+    while (i > 0 && heap->contents[(i - 1) / 2].priority > priority) {
+        heap->contents[i] = heap->contents[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->contents[i].cell = cell;
+    heap->contents[i].priority = priority;
+    ++heap->numNodes;
+}
+
+struct QueueContent heap_pop(Heap *heap) {
+    assert(!heap_isEmpty(heap));
+    struct QueueContent first = heap->contents[0];
+    struct QueueContent last = heap->contents[--heap->numNodes];
+    unsigned int i = 0;
+    while (2 * i + 1 < heap->numNodes) {
+        unsigned int child = 2 * i + 1;
+        if (child + 1 < heap->numNodes &&
+            heap->contents[child + 1].priority < heap->contents[child].priority) {
+            ++child;
+        }
+        if (heap->contents[child].priority >= last.priority) break;
+        heap->contents[i] = heap->contents[child];
+        i = child;
+    }
+    heap->contents[i] = last;
+    return first;
+}
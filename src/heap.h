@@ -0,0 +1,75 @@
+/**
+ * Module heap
+ *
+ * This module provides a binary min-heap (priority queue) data structure and
+ * functions operating on it.
+ *
+ * The elements of the heap are the same as the elements of a queue, i.e.
+ * nodes of a map graph together with a priority. The element having the
+ * smallest priority is always removed first.
+ */
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stdbool.h>
+#include "queue.h"
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+typedef struct {                   // A binary min-heap
+    struct QueueContent *contents; // The elements, stored as a binary tree
+    unsigned int numNodes;         // The number of elements in the heap
+    unsigned int capacity;         // The capacity of the heap
+} Heap;
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Creates an empty heap.
+ *
+ * The heap grows automatically if more than ``capacity`` elements are pushed.
+ *
+ * @param capacity  The initial capacity of the heap
+ * @return          The heap
+ */
+Heap heap_create(unsigned int capacity);
+
+/**
+ * Destroys the given heap.
+ *
+ * @param heap  The heap to be destroyed
+ */
+void heap_delete(Heap *heap);
+
+/**
+ * Returns true if the given heap is empty.
+ *
+ * @param heap  The heap to be checked
+ * @return      True if the heap is empty
+ */
+bool heap_isEmpty(const Heap *heap);
+
+/**
+ * Inserts a cell in the heap with given priority.
+ *
+ * @param heap      The heap in which the cell is inserted
+ * @param cell      The cell to be inserted
+ * @param priority  The priority to give to the cell
+ */
+void heap_push(Heap *heap,
+               struct MapCellNode *cell,
+               unsigned int priority);
+
+/**
+ * Removes the element of smallest priority in the heap and returns it.
+ *
+ * @param heap  The heap from which the element is removed
+ * @return      The element of smallest priority
+ */
+struct QueueContent heap_pop(Heap *heap);
+
+#endif
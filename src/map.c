@@ -17,11 +17,12 @@
  */
 void map_deleteLayer(struct Layer *layer) {
     if (layer != NULL) {
-        for (unsigned int i = 0; i < layer->numRows; ++i) {
-            free(layer->tiles[i]);
-            free(layer->highlight[i]);
+        for (unsigned int c = 0; c < layer->numChunkRows * layer->numChunkColumns;
+             ++c) {
+            free(layer->chunks[c]);
         }
-        free(layer->tiles);
+        free(layer->chunks);
+        free(layer->chunkCounts);
         free(layer->highlight);
     }
 }
@@ -33,12 +34,38 @@ void map_deleteLayer(struct Layer *layer) {
  */
 void map_deleteTile(struct Tile *tile) {
     if (tile != NULL) {
-        if (tile->name != NULL)     free(tile->name);
-        if (tile->filename != NULL) free(tile->filename);
-        if (tile->image != NULL)    cairo_surface_destroy(tile->image);
+        if (tile->image != NULL) cairo_surface_destroy(tile->image);
     }
 }
 
+/**
+ * Returns the image of the given tile, decoding it on first use.
+ *
+ * @param tile  The tile
+ * @return      The image of the tile
+ */
+cairo_surface_t *map_tileImage(struct Tile *tile) {
+    if (tile->image == NULL) {
+        tile->image = cairo_image_surface_create_from_png(tile->filename);
+    }
+    return tile->image;
+}
+
+/**
+ * Highlights a cell of the given map.
+ *
+ * @param map   The map
+ * @param cell  The cell to highlight
+ */
+void map_highlightCell(struct Map *map, const struct MapCell *cell) {
+    assert(cell->layer  < map->numLayers);
+    assert(cell->row    < map->numRows);
+    assert(cell->column < map->numColumns);
+    struct Layer *layer = &map->layers[cell->layer];
+    unsigned int index = cell->row * layer->numColumns + cell->column;
+    layer->highlight[index / 64] |= (uint64_t)1 << (index % 64);
+}
+
 /**
  * Prints the tile to stdout
  *
@@ -57,17 +84,18 @@ void map_printTile(const struct Tile *tile) {
     printf("\n");
 }
 /**
- * Prints the layer to stdout.
+ * Prints a layer of the map to stdout.
  *
- * @param layer  The layer to be printed
+ * @param map    The map
+ * @param layer  The number of the layer to be printed
  */
-void map_printLayer(const struct Layer *layer) {
+void map_printLayer(const struct Map *map, unsigned int layer) {
     printf("A layer of %d rows and %d columns\n",
-           layer->numRows, layer->numColumns);
-    for (unsigned int i = 0; i < layer->numRows; ++i) {
+           map->layers[layer].numRows, map->layers[layer].numColumns);
+    for (unsigned int i = 0; i < map->layers[layer].numRows; ++i) {
         printf("  ");
-        for (unsigned int j = 0; j < layer->numColumns; ++j) {
-            printf("%d ", layer->tiles[i][j]);
+        for (unsigned int j = 0; j < map->layers[layer].numColumns; ++j) {
+            printf("%d ", map_getTile(map, layer, i, j));
         }
         printf("\n");
     }
@@ -81,6 +109,8 @@ struct Map *map_createMap(unsigned int numRows,
                           unsigned int numColumns,
                           unsigned int maxLayers,
                           unsigned int maxTiles) {
+    assert(maxTiles <= 65536);
+    assert(maxLayers <= 65535);
     struct Map *map = (struct Map*)malloc(sizeof(struct Map));
     map->layers = (struct Layer*)malloc(maxLayers * sizeof(struct Layer));
     map->numLayers = 0;
@@ -88,12 +118,25 @@ struct Map *map_createMap(unsigned int numRows,
     map->numRows = numRows;
     map->numColumns = numColumns;
     map->tiles = (struct Tile*)malloc(maxTiles * sizeof(struct Tile));
-    map->tiles[0].name = strdup("empty");
-    map->tiles[0].filename = strdup("empty");
+    map->arena = arena_create(ARENA_BLOCK_SIZE);
+    map->tiles[0].name = arena_strdup(&map->arena, "empty");
+    map->tiles[0].filename = arena_strdup(&map->arena, "empty");
     map->tiles[0].image = NULL;
+    map->tiles[0].numDirections = 0;
+    map->tiles[0].directionMask = 0;
+    map->tiles[0].cost = 1;
     map->numTiles = 1;
     map->maxTiles = maxTiles;
+    map->heights = (uint16_t*)calloc(numRows * numColumns + 1,
+                                     sizeof(uint16_t));
     map->solution = NULL;
+    map->version = 0;
+    for (unsigned int bit = 0; bit < MAP_NUM_DIRECTIONS; ++bit) {
+        struct Direction direction = map_bitDirection(bit);
+        map->directionOffsets[bit] =
+            (direction.deltaLayer * (int)numRows + direction.deltaRow)
+            * (int)numColumns + direction.deltaColumn;
+    }
     return map;
 }
 
@@ -109,35 +152,79 @@ void map_deleteMap(struct Map *map) {
         }
         free(map->tiles);
         map->tiles = NULL;
+        arena_delete(&map->arena);
+        free(map->heights);
+        map->heights = NULL;
         free(map);
     }
 }
 
+unsigned int map_directionBit(const struct Direction *direction) {
+    assert(direction->deltaRow    >= -1 && direction->deltaRow    <= 1);
+    assert(direction->deltaColumn >= -1 && direction->deltaColumn <= 1);
+    assert(direction->deltaLayer  >= -1 && direction->deltaLayer  <= 1);
+    return 9 * (direction->deltaLayer + 1)
+         + 3 * (direction->deltaRow + 1)
+         + (direction->deltaColumn + 1);
+}
+
+struct Direction map_bitDirection(unsigned int bit) {
+    assert(bit < MAP_NUM_DIRECTIONS);
+    struct Direction direction = {
+        (int)(bit / 3 % 3) - 1,
+        (int)(bit % 3) - 1,
+        (int)(bit / 9) - 1
+    };
+    return direction;
+}
+
+unsigned int map_firstDirection(uint32_t mask) {
+    assert(mask != 0);
+#ifdef __GNUC__
+    return (unsigned int)__builtin_ctz(mask);
+#else
+    unsigned int bit = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+unsigned int map_numDirections(uint32_t mask) {
+#ifdef __GNUC__
+    return (unsigned int)__builtin_popcount(mask);
+#else
+    unsigned int numDirections = 0;
+    for (; mask != 0; mask &= mask - 1) {
+        ++numDirections;
+    }
+    return numDirections;
+#endif
+}
+
 void map_addDirection(struct Tile *tile,
                       const struct Direction *direction) {
     tile->directions[tile->numDirections] = *direction;
     ++tile->numDirections;
+    tile->directionMask |= (uint32_t)1 << map_directionBit(direction);
 }
 
 bool map_hasDirection(const struct Tile *tile,
                       const struct Direction *direction) {
-    for (unsigned int i = 0; i < tile->numDirections; ++i) {
-        if (tile->directions[i].deltaRow    == direction->deltaRow &&
-            tile->directions[i].deltaColumn == direction->deltaColumn &&
-            tile->directions[i].deltaLayer  == direction->deltaLayer) {
-            return true;
-        }
-    }
-    return false;
+    return (tile->directionMask & ((uint32_t)1 << map_directionBit(direction))) != 0;
 }
 
 struct Tile *map_addTile(struct Map *map, const char *name, const char *filename) {
-    if (map->numTiles < map->maxTiles + 1) {
+    if (map->numTiles < map->maxTiles) {
         struct Tile *tile = &map->tiles[map->numTiles];
-        tile->name = strdup(name);
-        tile->filename = strdup(filename);
-        tile->image = cairo_image_surface_create_from_png(filename);
+        tile->name = arena_strdup(&map->arena, name);
+        tile->filename = arena_strdup(&map->arena, filename);
+        tile->image = NULL;
         tile->numDirections = 0;
+        tile->directionMask = 0;
+        tile->cost = 1;
         ++map->numTiles;
         return tile;
     } else {
@@ -146,36 +233,84 @@ struct Tile *map_addTile(struct Map *map, const char *name, const char *filename
 }
 
 struct Layer *map_addLayer(struct Map *map, double offsetx, double offsety) {
-    if (map->numLayers < map->maxLayers + 1) {
+    if (map->numLayers < map->maxLayers) {
         struct Layer *layer = &map->layers[map->numLayers];
         layer->map = map;
         layer->numRows = map->numRows;
         layer->numColumns = map->numColumns;
         layer->offsetx = offsetx;
         layer->offsety = offsety;
-        layer->tiles = (unsigned int**)malloc(layer->numRows * sizeof(unsigned int*));
-        layer->highlight = (bool**)malloc(layer->numRows * sizeof(bool*));
-        for (unsigned int i = 0; i < layer->numRows; ++i) {
-            layer->tiles[i] = (unsigned int*)malloc(layer->numColumns * sizeof(unsigned int));
-            layer->highlight[i] = (bool*)malloc(layer->numColumns * sizeof(bool));
-            for (unsigned int j = 0; j < layer->numColumns; ++j) {
-                layer->tiles[i][j] = 0;
-                layer->highlight[i][j] = false;
-            }
-        }
+        unsigned int numCells = layer->numRows * layer->numColumns;
+        layer->numChunkRows = (layer->numRows + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+        layer->numChunkColumns =
+            (layer->numColumns + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+        unsigned int numChunks = layer->numChunkRows * layer->numChunkColumns;
+        layer->chunks = (uint8_t**)calloc(numChunks + 1, sizeof(uint8_t*));
+        layer->chunkCounts = (uint16_t*)calloc(numChunks + 1, sizeof(uint16_t));
+        layer->wideTileIDs = map->maxTiles > 256;
+        layer->highlight = (uint64_t*)calloc(numCells / 64 + 1, sizeof(uint64_t));
         ++map->numLayers;
+        ++map->version;
         return layer;
     } else {
         return NULL;
     }
 }
 
+void map_setTile(struct Map *map,
+                 unsigned int layer,
+                 unsigned int row,
+                 unsigned int column,
+                 unsigned int tileID) {
+    assert(layer  < map->numLayers);
+    assert(row    < map->numRows);
+    assert(column < map->numColumns);
+    assert(tileID < map->numTiles);
+    struct Layer *tileLayer = &map->layers[layer];
+    unsigned int c = (row / MAP_CHUNK_SIZE) * tileLayer->numChunkColumns
+                     + column / MAP_CHUNK_SIZE;
+    unsigned int index =
+        (row % MAP_CHUNK_SIZE) * MAP_CHUNK_SIZE + column % MAP_CHUNK_SIZE;
+    unsigned int previousID = map_getTile(map, layer, row, column);
+    if (tileLayer->chunks[c] == NULL) {
+        if (tileID == 0) return;
+        tileLayer->chunks[c] = (uint8_t*)calloc(MAP_CHUNK_SIZE * MAP_CHUNK_SIZE,
+                                                tileLayer->wideTileIDs ? 2 : 1);
+    }
+    if (tileLayer->wideTileIDs) {
+        ((uint16_t*)tileLayer->chunks[c])[index] = (uint16_t)tileID;
+    } else {
+        tileLayer->chunks[c][index] = (uint8_t)tileID;
+    }
+    if (previousID == 0 && tileID != 0) {
+        ++tileLayer->chunkCounts[c];
+    } else if (previousID != 0 && tileID == 0 &&
+               --tileLayer->chunkCounts[c] == 0) {
+        free(tileLayer->chunks[c]);
+        tileLayer->chunks[c] = NULL;
+    }
+    uint16_t *height = &map->heights[row * map->numColumns + column];
+    if (tileID != 0 && layer >= *height) {
+        *height = layer + 1;
+    } else if (tileID == 0 && layer + 1 == *height) {
+        while (*height > 0 &&
+               map_getTile(map, *height - 1, row, column) == 0) {
+            --*height;
+        }
+    }
+    ++map->version;
+}
+
 void map_addSolution(struct Map *map, struct MapGraphPath *path) {
     map->solution = path;
-    while (path != NULL) {
-        map->layers[path->head.layer].highlight[path->head.row][path->head.column]
-            = true;
-        path = path->tail;
+    for (unsigned int i = 0; path != NULL && i < path->numCells; ++i) {
+        map_highlightCell(map, &path->cells[i]);
+    }
+}
+
+void map_addRange(struct Map *map, const struct MapGraphRange *range) {
+    for (unsigned int i = 0; i < range->numCells; ++i) {
+        map_highlightCell(map, &range->cells[i]);
     }
 }
 
@@ -186,9 +321,9 @@ bool map_hasTileAbove(const struct Map *map,
     assert(layer  < map->numLayers);
     assert(row    < map->numRows);
     assert(column < map->numColumns);
-    assert(map->layers[layer].tiles[row][column] != 0);
-    return layer < map->numLayers - 1 &&
-        map->layers[layer + 1].tiles[row][column] != 0;
+    assert(map_getTile(map, layer, row, column) != 0);
+    return layer + 1 < map_getHeight(map, row, column) &&
+        map_getTile(map, layer + 1, row, column) != 0;
 }
 
 void map_printMap(const struct Map *map, bool withSolution) {
@@ -200,7 +335,7 @@ void map_printMap(const struct Map *map, bool withSolution) {
     }
     for (unsigned int i = 0; i < map->numLayers; ++i) {
         printf("  Layer %d: ", i);
-        map_printLayer(&map->layers[i]);
+        map_printLayer(map, i);
     }
     if (withSolution && map->solution != NULL) {
         printf("  Solution: ");
@@ -208,7 +343,7 @@ void map_printMap(const struct Map *map, bool withSolution) {
     }
 }
 
-void map_toPNG(const struct Map *map, const char *outputFilename) {
+void map_toPNG(struct Map *map, const char *outputFilename) {
     unsigned int width  = 128 * (map->numRows + map->numColumns + 1);
     unsigned int height = 64  * (map->numRows + map->numColumns + map->numLayers + 2);
     cairo_surface_t *outputImage =
@@ -223,27 +358,29 @@ void map_toPNG(const struct Map *map, const char *outputFilename) {
         cairo_translate(cr, map->layers[k].offsetx,
                             map->layers[k].offsety);
         for (unsigned int i = 0; i < map->numRows; ++i) {
-            cairo_save(cr);
             for (unsigned int j = 0; j < map->numColumns; ++j) {
-                unsigned int tileID = map->layers[k].tiles[i][j];
+                if (map_isChunkEmpty(map, k, i, j)) {
+                    j |= MAP_CHUNK_SIZE - 1;
+                    continue;
+                }
+                unsigned int tileID = map_getTile(map, k, i, j);
                 if (tileID != 0) {
-                    cairo_surface_t *image = map->tiles[tileID].image;
+                    cairo_save(cr);
+                    cairo_translate(cr, 128 * j, 64 * j);
                     cairo_pattern_t *imagePattern =
-                        cairo_pattern_create_for_surface(image);
+                        cairo_pattern_create_for_surface(
+                            map_tileImage(&map->tiles[tileID]));
                     cairo_set_source(cr, imagePattern);
                     cairo_paint(cr);
                     cairo_pattern_destroy(imagePattern);
-                    if (map->layers[k].highlight[i][j]) {
-                        cairo_save(cr);
+                    if (map_isHighlighted(map, k, i, j)) {
                         cairo_set_operator(cr, CAIRO_OPERATOR_ADD);
                         cairo_set_source(cr, imagePattern);
                         cairo_paint(cr);
-                        cairo_restore(cr);
                     }
+                    cairo_restore(cr);
                 }
-                cairo_translate(cr, 128, 64);
             }
-            cairo_restore(cr);
             cairo_translate(cr, -128, 64);
         }
         cairo_restore(cr);
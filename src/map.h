@@ -57,6 +57,36 @@
  * - ``struct Layer``, representing a layer in the map;
  * - ``struct Map``, representing the map.
  *
+ * Since each displacement of a direction is -1, 0 or 1, there are 27
+ * possible directions, and the direction (dR,dC,dL) is numbered
+ * ``9 * (dL + 1) + 3 * (dR + 1) + (dC + 1)``. The directions of a tile are
+ * thus also stored as a 27-bit mask, so that checking a direction is a single
+ * bitwise AND and the opposite of direction ``b`` is direction ``26 - b``.
+ * The map keeps, for each direction, the difference between the flat indices
+ * ``(L * numRows + R) * numColumns + C`` of a cell and of its neighbor in
+ * that direction.
+ *
+ * Since the upper layers of a map are mostly empty, the tiles of a layer are
+ * stored by chunks of ``MAP_CHUNK_SIZE`` x ``MAP_CHUNK_SIZE`` cells, and only
+ * the chunks holding at least one tile are allocated. The tiles of a chunk
+ * are stored row by row and take one byte each when the map allows at most
+ * 256 tiles (two bytes otherwise). Loops over the cells of a layer can skip
+ * the empty chunks with ``map_isChunkEmpty``, so that their work is
+ * proportional to the number of tiles rather than to the size of the map.
+ * The highlighted cells of a layer are stored as a bitset, row by row. The
+ * tiles and highlights must be accessed through ``map_getTile``,
+ * ``map_setTile`` and ``map_isHighlighted``.
+ *
+ * The map also keeps a heightmap giving, for each column (R,C), the number of
+ * layers up to its top tile (0 if the column is empty). It is updated by
+ * ``map_setTile`` and read with ``map_getHeight``: a tile is at the top of
+ * its column exactly when its layer is the height minus one, and the layers
+ * at and above the height are known to be empty without looking at them.
+ *
+ * Each map has a version, which is incremented by every change of its tiles
+ * done through ``map_addLayer`` and ``map_setTile``, so that the results
+ * computed from a map (such as cached paths) can be checked against it.
+ *
  * @author   Alexandre Blondin Massé
  * @version  1.0
  * @date     June 18th, 2017
@@ -66,9 +96,17 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <cairo.h>
+#include "arena.h"
 #include "map_graph.h"
 
+struct MapGraphRange;
+
+#define MAP_NUM_DIRECTIONS 27 // The number of directions whose displacements
+                              // are in {-1, 0, 1}
+#define MAP_CHUNK_SIZE 32     // The number of rows and columns of a chunk
+
 // --------------- //
 // Data structures //
 // --------------- //
@@ -84,17 +122,25 @@ struct Tile {                        // A tile
     char *filename;                  // The filename of the image for the tile
     struct Direction directions[12]; // The allowed directions
     unsigned int numDirections;      // The number of directions
-    cairo_surface_t *image;          // The image of the tile
+    uint32_t directionMask;          // The bit of each allowed direction
+    unsigned int cost;               // The cost of a move onto the tile
+    cairo_surface_t *image;          // The image of the tile (NULL until
+                                     // the tile is first drawn)
 };
 
-struct Layer {               // A layer
-    struct Map *map;         // The map in which the layer is
-    unsigned int **tiles;    // A matrix of the tiles in the layer
-    bool **highlight;        // If true, hilight the tile
-    unsigned int numRows;    // The number of rows
-    unsigned int numColumns; // The number of columns
-    double offsetx;          // The x-offset
-    double offsety;          // The y-offset
+struct Layer {                    // A layer
+    struct Map *map;              // The map in which the layer is
+    uint8_t **chunks;             // The tile IDs of each chunk, row by row
+                                  // (NULL if the chunk is empty)
+    uint16_t *chunkCounts;        // The number of tiles in each chunk
+    unsigned int numChunkRows;    // The number of rows of chunks
+    unsigned int numChunkColumns; // The number of columns of chunks
+    bool wideTileIDs;             // If true, each tile ID takes two bytes
+    uint64_t *highlight;          // The highlighted cells, one bit per cell
+    unsigned int numRows;         // The number of rows
+    unsigned int numColumns;      // The number of columns
+    double offsetx;               // The x-offset
+    double offsety;               // The y-offset
 };
 
 struct Map {                       // A map
@@ -107,7 +153,15 @@ struct Map {                       // A map
     unsigned int numTiles;         // The number of allowed tiles in the map
     unsigned int maxTiles;         // The maximum number of allowed tiles in
                                    // the map
+    int directionOffsets[MAP_NUM_DIRECTIONS]; // The flat index offset of
+                                              // each direction
+    struct Arena arena;            // The memory of the names and filenames
+                                   // of the tiles
+    uint16_t *heights;             // The number of layers up to the top
+                                   // tile of each column, row by row
     struct MapGraphPath *solution; // The solution of the map
+    unsigned int version;          // Incremented whenever the tiles of the
+                                   // map change
 };
 
 // --------- //
@@ -119,8 +173,10 @@ struct Map {                       // A map
  *
  * @param numRows     The number of rows of the map
  * @param numColumns  The number of columns of the map
- * @param maxLayers   The maximum number of layers in the map
- * @param maxTiles    The maximum number of allowed tiles in the map
+ * @param maxLayers   The maximum number of layers in the map (at most
+ *                    65535)
+ * @param maxTiles    The maximum number of allowed tiles in the map (at
+ *                    most 65536, the empty tile included)
  * @return            The created map
  */
 struct Map *map_createMap(unsigned int numRows,
@@ -135,9 +191,46 @@ struct Map *map_createMap(unsigned int numRows,
  */
 void map_deleteMap(struct Map *map);
 
+/**
+ * Returns the number of the given direction, between 0 and 26.
+ *
+ * @param direction  The direction, whose displacements are in {-1, 0, 1}
+ * @return           The number of the direction
+ */
+unsigned int map_directionBit(const struct Direction *direction);
+
+/**
+ * Returns the direction having the given number.
+ *
+ * @param bit  The number of the direction, between 0 and 26
+ * @return     The direction
+ */
+struct Direction map_bitDirection(unsigned int bit);
+
+/**
+ * Returns the number of the first direction in the given mask.
+ *
+ * Together with ``mask &= mask - 1``, which removes this direction from the
+ * mask, this allows to loop over the directions of a tile.
+ *
+ * @param mask  A nonempty mask of directions
+ * @return      The number of the first direction in the mask
+ */
+unsigned int map_firstDirection(uint32_t mask);
+
+/**
+ * Returns the number of directions in the given mask.
+ *
+ * @param mask  A mask of directions
+ * @return      The number of directions in the mask
+ */
+unsigned int map_numDirections(uint32_t mask);
+
 /**
  * Adds an allowed direction to the given tile.
  *
+ * The displacements of the direction must be in {-1, 0, 1}.
+ *
  * @param tile       The tile to which the direction is added
  * @param direction  The allowed direction
  */
@@ -157,6 +250,9 @@ bool map_hasDirection(const struct Tile *tile,
 /**
  * Adds a tile to the given map.
  *
+ * The cost of a move onto the new tile is 1. The image file is not read
+ * until the tile is drawn by ``map_toPNG``.
+ *
  * @param map       The map to which the tile is added
  * @param name      The name of the tile
  * @param filename  The filename of the image for the tile
@@ -176,6 +272,103 @@ struct Tile *map_addTile(struct Map *map,
  */
 struct Layer *map_addLayer(struct Map *map, double offsetx, double offsety);
 
+/**
+ * Places a tile on a cell of the given map.
+ *
+ * The version of the map is incremented, so that the paths computed on the
+ * previous version are known to be outdated.
+ *
+ * @param map     The map
+ * @param layer   The layer of the cell
+ * @param row     The row of the cell
+ * @param column  The column of the cell
+ * @param tileID  The ID of the tile (0 for the empty tile)
+ */
+void map_setTile(struct Map *map,
+                 unsigned int layer,
+                 unsigned int row,
+                 unsigned int column,
+                 unsigned int tileID);
+
+/**
+ * Returns the ID of the tile on a cell of the given map.
+ *
+ * @param map     The map
+ * @param layer   The layer of the cell
+ * @param row     The row of the cell
+ * @param column  The column of the cell
+ * @return        The ID of the tile (0 for the empty tile)
+ */
+static inline unsigned int map_getTile(const struct Map *map,
+                                       unsigned int layer,
+                                       unsigned int row,
+                                       unsigned int column) {
+    const struct Layer *tileLayer = &map->layers[layer];
+    const uint8_t *chunk =
+        tileLayer->chunks[(row / MAP_CHUNK_SIZE) * tileLayer->numChunkColumns
+                          + column / MAP_CHUNK_SIZE];
+    if (chunk == NULL) return 0;
+    unsigned int index =
+        (row % MAP_CHUNK_SIZE) * MAP_CHUNK_SIZE + column % MAP_CHUNK_SIZE;
+    return tileLayer->wideTileIDs ? ((const uint16_t*)chunk)[index]
+                                  : chunk[index];
+}
+
+/**
+ * Returns the number of layers up to the top tile of a column of the given
+ * map.
+ *
+ * @param map     The map
+ * @param row     The row of the column
+ * @param column  The column
+ * @return        The layer of the top tile plus one (0 if the column is
+ *                empty)
+ */
+static inline unsigned int map_getHeight(const struct Map *map,
+                                         unsigned int row,
+                                         unsigned int column) {
+    return map->heights[row * map->numColumns + column];
+}
+
+/**
+ * Returns true if the chunk containing a cell of the given map is empty.
+ *
+ * A loop over the columns of a row can then jump to the next chunk with
+ * ``column |= MAP_CHUNK_SIZE - 1``.
+ *
+ * @param map     The map
+ * @param layer   The layer of the cell
+ * @param row     The row of the cell
+ * @param column  The column of the cell
+ * @return        True if no cell of the chunk has a tile
+ */
+static inline bool map_isChunkEmpty(const struct Map *map,
+                                    unsigned int layer,
+                                    unsigned int row,
+                                    unsigned int column) {
+    const struct Layer *tileLayer = &map->layers[layer];
+    return tileLayer->chunks[(row / MAP_CHUNK_SIZE) * tileLayer->numChunkColumns
+                             + column / MAP_CHUNK_SIZE] == NULL;
+}
+
+/**
+ * Returns true if a cell of the given map is highlighted.
+ *
+ * @param map     The map
+ * @param layer   The layer of the cell
+ * @param row     The row of the cell
+ * @param column  The column of the cell
+ * @return        True if the cell is highlighted
+ */
+static inline bool map_isHighlighted(const struct Map *map,
+                                     unsigned int layer,
+                                     unsigned int row,
+                                     unsigned int column) {
+    const struct Layer *tileLayer = &map->layers[layer];
+    unsigned int index = row * tileLayer->numColumns + column;
+    return (tileLayer->highlight[index / 64] >> (index % 64) & 1) != 0;
+}
+
 /**
  * Adds a solution to the given map.
  *
@@ -184,6 +377,14 @@ struct Layer *map_addLayer(struct Map *map, double offsetx, double offsety);
  */
 void map_addSolution(struct Map *map, struct MapGraphPath *path);
 
+/**
+ * Highlights a region of the given map.
+ *
+ * @param map    The map
+ * @param range  The cells to highlight
+ */
+void map_addRange(struct Map *map, const struct MapGraphRange *range);
+
 /**
  * Returns true if the given tile has another tile above itself.
  *
@@ -207,9 +408,13 @@ void map_printMap(const struct Map *map, bool withSolution);
 /**
  * Generates a PNG file for the given map.
  *
+ * The image of each tile is decoded the first time the tile is drawn and
+ * kept with the tile, so that only the tiles appearing on the map are read,
+ * and only by runs producing an image. The map is therefore modified.
+ *
  * @param map             The map to be drawn
  * @param outputFilename  The output filename
  */
-void map_toPNG(const struct Map *map, const char *outputFilename);
+void map_toPNG(struct Map *map, const char *outputFilename);
 
 #endif
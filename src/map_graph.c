@@ -3,6 +3,8 @@
 #include <string.h>
 #include "map_graph.h"
 #include "queue.h"
+#include "heap.h"
+#include "radix_heap.h"
 
 // ----------------- //
 // Private functions //
@@ -11,21 +13,29 @@
 /**
  * Prints the given node.
  *
- * @param node  The node to print
+ * @param node           The node to print
+ * @param withComponent  Prints the component of the node if true
  */
-void mapgraph_printNode(const struct MapCellNode *node) {
-    printf("  Node #%d of cell (%d,%d,%d) containing tile \"%s\" with %d neighbors\n",
+void mapgraph_printNode(const struct MapCellNode *node, bool withComponent) {
+    printf("  Node #%d of cell (%d,%d,%d) containing tile \"%s\" with %d neighbors",
            node->index,
            node->cell.row,
            node->cell.column,
            node->cell.layer,
            node->tile->name,
            node->numNeighbors);
+    if (withComponent) {
+        printf(" in component %d", node->component);
+    }
+    printf("\n");
 }
 
 /**
  * Adds a new cell to the given graph.
  *
+ * Since each edge is added once from each of its ends, the neighbors of the
+ * node are given room for two neighbors in each direction of the tile.
+ *
  * @param graph   The graph
  * @param tile    The tile associated with the cell
  * @param row     The row of the cell
@@ -48,16 +58,65 @@ void mapgraph_addCell(struct MapGraph *graph,
     node->cell.column = column;
     node->cell.layer = layer;
     node->tile = tile;
-    node->neighbors = (struct MapCellNode**)malloc(sizeof(struct MapCellNode*));
     node->numNeighbors = 0;
-    node->capacity = 1;
+    node->capacity = 2 * map_numDirections(tile->directionMask);
+    node->neighbors = node->capacity == 0 ? NULL :
+        (struct MapCellNode**)arena_alloc(
+            &graph->arena, node->capacity * sizeof(struct MapCellNode*));
+    node->component = 0;
+    graph->nodeIndex[(layer * graph->map->numRows + row)
+                     * graph->map->numColumns + column] = graph->numNodes;
     ++graph->numNodes;
 }
 
+/**
+ * Lists the cells of a map that can be visited, column by column.
+ *
+ * Only the layers below the height of each column are looked at, and the
+ * top tile of a column is known without looking at it. A cell can be visited
+ * if it has a tile and the cell above it is empty, so that a column has a
+ * free cell at its top and one under each gap.
+ *
+ * If ``cells`` is NULL, the number of free cells of each layer ``k`` is added
+ * to ``layerOffsets[k + 1]``. Otherwise, the flat index of each free cell of
+ * layer ``k`` is stored at position ``layerOffsets[k]`` of ``cells``, which
+ * is then incremented. Since the columns are visited row by row, the cells
+ * of each layer are listed in the order of their flat indices.
+ *
+ * @param map           The map
+ * @param layerOffsets  The number or the next position of the free cells of
+ *                      each layer
+ * @param cells         The flat indices of the free cells (may be NULL)
+ */
+void mapgraph_listFreeCells(const struct Map *map,
+                            unsigned int *layerOffsets,
+                            unsigned int *cells) {
+    for (unsigned int i = 0; i < map->numRows; ++i) {
+        for (unsigned int j = 0; j < map->numColumns; ++j) {
+            unsigned int height = map_getHeight(map, i, j);
+            bool covered = false;
+            for (unsigned int k = height; k-- > 0;) {
+                bool occupied = k + 1 == height ||
+                                map_getTile(map, k, i, j) != 0;
+                if (occupied && !covered) {
+                    if (cells == NULL) {
+                        ++layerOffsets[k + 1];
+                    } else {
+                        cells[layerOffsets[k]++] =
+                            (k * map->numRows + i) * map->numColumns + j;
+                    }
+                }
+                covered = occupied;
+            }
+        }
+    }
+}
+
 /**
  * Returns the node in the given graph associated with a cell.
  *
- * If the cell does not exist in the graph, NULL is returned.
+ * If the cell does not exist in the graph, NULL is returned. The lookup is
+ * done in constant time through the dense index of the graph.
  *
  * @param graph  The graph
  * @param cell   A cell in the graph
@@ -65,27 +124,41 @@ void mapgraph_addCell(struct MapGraph *graph,
  */
 struct MapCellNode *mapgraph_getNode(const struct MapGraph *graph,
                                      const struct MapCell *cell) {
-    for (unsigned int i = 0; i < graph->numNodes; ++i) {
-        if (graph->nodes[i].cell.row == cell->row &&
-            graph->nodes[i].cell.column == cell->column &&
-            graph->nodes[i].cell.layer == cell->layer)
-            return &graph->nodes[i];
+    const struct Map *map = graph->map;
+    if (cell->row    >= map->numRows    ||
+        cell->column >= map->numColumns ||
+        cell->layer  >= map->numLayers) {
+        return NULL;
     }
-    return NULL;
+    unsigned int index =
+        graph->nodeIndex[(cell->layer * map->numRows + cell->row)
+                         * map->numColumns + cell->column];
+    return index == MAPGRAPH_NO_NODE ? NULL : &graph->nodes[index];
 }
 
 /**
  * Adds a neighbor to the given node.
  *
+ * The neighbors are allocated from the arena of the graph. When they are
+ * full, they are copied to an array twice as large and the old array is
+ * left in the arena until it is released.
+ *
+ * @param arena     The arena of the graph
  * @param node      The node to which a neighbor is added
  * @param neighbor  The neighbor
  */
-void mapgraph_addNeighborToNode(struct MapCellNode *node,
+void mapgraph_addNeighborToNode(struct Arena *arena,
+                                struct MapCellNode *node,
                                 struct MapCellNode *neighbor) {
     if (node->numNeighbors == node->capacity) {
-        node->capacity *= 2;
-        node->neighbors = realloc(node->neighbors,
-                                  node->capacity * sizeof(struct MapCellNode*));
+        struct MapCellNode **neighbors = node->neighbors;
+        node->capacity = node->capacity > 0 ? 2 * node->capacity : 4;
+        node->neighbors = (struct MapCellNode**)arena_alloc(
+            arena, node->capacity * sizeof(struct MapCellNode*));
+        if (node->numNeighbors > 0) {
+            memcpy(node->neighbors, neighbors,
+                   node->numNeighbors * sizeof(struct MapCellNode*));
+        }
     }
     node->neighbors[node->numNeighbors] = neighbor;
     ++node->numNeighbors;
@@ -117,12 +190,169 @@ void mapgraph_addNeighbor(struct MapGraph *graph,
     struct MapCell neighbor = {row + deltaRow,
                                column + deltaColumn,
                                layer + deltaLayer};
+    assert(graph->neighborOffsets == NULL);
     struct MapCellNode *cellNode = mapgraph_getNode(graph, &cell);
     struct MapCellNode *neighborNode = mapgraph_getNode(graph, &neighbor);
     if (cellNode != NULL && neighborNode != NULL) {
-        mapgraph_addNeighborToNode(cellNode, neighborNode);
-        mapgraph_addNeighborToNode(neighborNode, cellNode);
+        mapgraph_addNeighborToNode(&graph->arena, cellNode, neighborNode);
+        mapgraph_addNeighborToNode(&graph->arena, neighborNode, cellNode);
+    }
+}
+
+/**
+ * Expands one whole level of one side of a bidirectional BFS.
+ *
+ * Every node of the current frontier (i.e. every node in the queue of the
+ * workspace of this side) is removed and its unvisited neighbors are added to
+ * the queue. Each neighbor already reached by the other side yields a path,
+ * and the shortest such path is kept in ``bestLength`` and ``meetingIndex``.
+ *
+ * @param side          The workspace of this side
+ * @param other         The workspace of the other side
+ * @param bestLength    The length of the shortest path found so far
+ * @param meetingIndex  The node where the shortest path found so far meets
+ */
+void mapgraph_expandLevel(struct MapGraphSearch *side,
+                          const struct MapGraphSearch *other,
+                          int *bestLength,
+                          unsigned int *meetingIndex) {
+    const struct MapGraph *graph = side->graph;
+    unsigned int levelSize = side->queue.numNodes;
+    for (unsigned int k = 0; k < levelSize; ++k) {
+        struct QueueContent content = queue_dequeue(&side->queue);
+        unsigned int numNeighbors =
+            mapgraph_numNeighbors(graph, content.cell->index);
+        for (unsigned int i = 0; i < numNeighbors; ++i) {
+            unsigned int index =
+                mapgraph_getNeighbor(graph, content.cell->index, i);
+            if (side->generations[index] != side->generation) {
+                side->generations[index] = side->generation;
+                side->distance[index] = content.priority + 1;
+                side->predecessors[index] = content.cell;
+                queue_enqueue(&side->queue, &graph->nodes[index],
+                              content.priority + 1);
+            }
+            if (other->generations[index] == other->generation &&
+                (*bestLength == -1 ||
+                 side->distance[index] + other->distance[index] < *bestLength)) {
+                *bestLength = side->distance[index] + other->distance[index];
+                *meetingIndex = index;
+            }
+        }
+    }
+}
+
+/**
+ * Returns true if the given node is a goal of a breadth-first search.
+ *
+ * @param graph        The graph
+ * @param node         The node
+ * @param endNode      The ending node (NULL if none)
+ * @param targetTiles  Whether each tile is a target (NULL if none)
+ * @return             True if the node is the ending node or a target
+ */
+bool mapgraph_isGoal(const struct MapGraph *graph,
+                     const struct MapCellNode *node,
+                     const struct MapCellNode *endNode,
+                     const bool *targetTiles) {
+    return node == endNode ||
+           (targetTiles != NULL && targetTiles[node->tile - graph->map->tiles]);
+}
+
+/**
+ * Visits the nodes of the graph by a breadth-first search in the given
+ * workspace, starting from one or more nodes at once.
+ *
+ * Every starting node is at distance 0 and is its own predecessor. The search
+ * stops as soon as a goal is reached, a goal being either the ending node or
+ * a node whose tile is a target. If there is no goal, every node connected to
+ * a starting node is visited, up to the given distance.
+ *
+ * Since each node is enqueued at most once, the buffer of the queue of the
+ * workspace holds, once the search is done, the visited nodes in the order
+ * of their visit, from position 0 to position ``head + numNodes - 1``.
+ *
+ * @param search         The search workspace
+ * @param startNodes     The starting nodes
+ * @param numStartNodes  The number of starting nodes
+ * @param endNode        The ending node (NULL if none)
+ * @param targetTiles    Whether each tile of the map is a target, by tile ID
+ *                       (NULL if none)
+ * @param maxDistance    The distance beyond which no node is visited (-1 if
+ *                       there is no limit)
+ * @return               The first goal reached, or NULL if there is none
+ */
+const struct MapCellNode *mapgraph_breadthFirstSearch(struct MapGraphSearch *search,
+                                                      struct MapCellNode **startNodes,
+                                                      unsigned int numStartNodes,
+                                                      const struct MapCellNode *endNode,
+                                                      const bool *targetTiles,
+                                                      int maxDistance) {
+    const struct MapGraph *graph = search->graph;
+    struct MapCellNode **predecessors = search->predecessors;
+    int *distance = search->distance;
+    unsigned int *generations = search->generations;
+    unsigned int generation = mapgraph_nextGeneration(search);
+    const struct MapCellNode *goal = NULL;
+    Queue *queue = &search->queue;
+    queue_clear(queue);
+    for (unsigned int s = 0; s < numStartNodes; ++s) {
+        struct MapCellNode *startNode = startNodes[s];
+        if (generations[startNode->index] == generation) continue;
+        queue_enqueue(queue, startNode, 0);
+        distance[startNode->index] = 0;
+        predecessors[startNode->index] = startNode;
+        generations[startNode->index] = generation;
+        if (goal == NULL &&
+            mapgraph_isGoal(graph, startNode, endNode, targetTiles)) {
+            goal = startNode;
+        }
+    }
+    while (!queue_isEmpty(queue) && goal == NULL) {
+        struct QueueContent content = queue_dequeue(queue);
+        if ((int)content.priority == maxDistance) continue;
+        unsigned int numNeighbors =
+            mapgraph_numNeighbors(graph, content.cell->index);
+        for (unsigned int i = 0; i < numNeighbors && goal == NULL; ++i) {
+            unsigned int index =
+                mapgraph_getNeighbor(graph, content.cell->index, i);
+            if (generations[index] != generation) {
+                generations[index] = generation;
+                distance[index] = content.priority + 1;
+                predecessors[index] = content.cell;
+                queue_enqueue(queue, &graph->nodes[index], content.priority + 1);
+                if (mapgraph_isGoal(graph, &graph->nodes[index],
+                                    endNode, targetTiles)) {
+                    goal = &graph->nodes[index];
+                }
+            }
+        }
+    }
+    return goal;
+}
+
+/**
+ * Returns which tiles of a map have the given name.
+ *
+ * @param map       The map
+ * @param tileName  The name of the tiles
+ * @return          Whether each tile has the name, by tile ID, or NULL if
+ *                  no tile has the name
+ */
+bool *mapgraph_tilesNamed(const struct Map *map, const char *tileName) {
+    bool *tiles = (bool*)calloc(map->numTiles, sizeof(bool));
+    bool found = false;
+    for (unsigned int t = 1; t < map->numTiles; ++t) {
+        if (strcmp(map->tiles[t].name, tileName) == 0) {
+            tiles[t] = true;
+            found = true;
+        }
     }
+    if (!found) {
+        free(tiles);
+        tiles = NULL;
+    }
+    return tiles;
 }
 
 // --------- //
@@ -135,54 +365,183 @@ struct MapGraph mapgraph_create(const struct Map *map) {
     graph.nodes = (struct MapCellNode*)malloc(sizeof(struct MapCellNode));
     graph.numNodes = 0;
     graph.capacity = 1;
+    graph.neighborOffsets = NULL;
+    graph.neighborIndices = NULL;
+    graph.numArcs = 0;
+    graph.numComponents = 0;
+    graph.version = map->version;
+    graph.arena = arena_create(ARENA_BLOCK_SIZE);
+    unsigned int numCells = map->numLayers * map->numRows * map->numColumns;
+    graph.nodeIndex = (unsigned int*)malloc(numCells * sizeof(unsigned int));
+    for (unsigned int i = 0; i < numCells; ++i) {
+        graph.nodeIndex[i] = MAPGRAPH_NO_NODE;
+    }
+    unsigned int *layerOffsets =
+        (unsigned int*)calloc(map->numLayers + 1, sizeof(unsigned int));
+    mapgraph_listFreeCells(map, layerOffsets, NULL);
     for (unsigned int k = 0; k < map->numLayers; ++k) {
-        for (unsigned int i = 0; i < map->numRows; ++i) {
-            for (unsigned int j = 0; j < map->numColumns; ++j) {
-                unsigned int tileID = map->layers[k].tiles[i][j];
-                if (tileID != 0 &&
-                    !map_hasTileAbove(map, i, j, k)) {
-                    mapgraph_addCell(&graph, &map->tiles[tileID], i, j, k);
-                }
-            }
-        }
+        layerOffsets[k + 1] += layerOffsets[k];
+    }
+    unsigned int numFreeCells = layerOffsets[map->numLayers];
+    unsigned int *freeCells =
+        (unsigned int*)malloc((numFreeCells > 0 ? numFreeCells : 1)
+                              * sizeof(unsigned int));
+    mapgraph_listFreeCells(map, layerOffsets, freeCells);
+    if (numFreeCells > graph.capacity) {
+        graph.capacity = numFreeCells;
+        graph.nodes = realloc(graph.nodes,
+                              graph.capacity * sizeof(struct MapCellNode));
+    }
+    for (unsigned int c = 0; c < numFreeCells; ++c) {
+        unsigned int i = (freeCells[c] / map->numColumns) % map->numRows;
+        unsigned int j = freeCells[c] % map->numColumns;
+        unsigned int k = freeCells[c] / (map->numColumns * map->numRows);
+        mapgraph_addCell(&graph, &map->tiles[map_getTile(map, k, i, j)],
+                         i, j, k);
     }
+    free(layerOffsets);
+    free(freeCells);
     for (unsigned int i = 0; i < graph.numNodes; ++i) {
         const struct MapCell *cell = &graph.nodes[i].cell;
-        unsigned int tileID = map->layers[cell->layer].tiles[cell->row][cell->column];
-        const struct Tile *tile = &map->tiles[tileID];
-        for (unsigned int j = 0; j < tile->numDirections; ++j) {
-            struct Direction direction = tile->directions[j];
-            struct Direction opposite = {
-                -direction.deltaRow,
-                -direction.deltaColumn,
-                -direction.deltaLayer
-            };
-            struct MapCell neighbor = {
-                cell->row + direction.deltaRow,
-                cell->column + direction.deltaColumn,
-                cell->layer + direction.deltaLayer
-            };
-            struct MapCellNode *neighborNode = mapgraph_getNode(&graph, &neighbor);
-            if (neighborNode != NULL) {
-                struct Tile *neighborTile = neighborNode->tile;
-                if (map_hasDirection(neighborTile, &opposite)) {
-                    mapgraph_addNeighborToNode(&graph.nodes[i], neighborNode);
-                    mapgraph_addNeighborToNode(neighborNode, &graph.nodes[i]);
-                }
+        unsigned int cellIndex =
+            (cell->layer * map->numRows + cell->row) * map->numColumns
+            + cell->column;
+        for (uint32_t mask = graph.nodes[i].tile->directionMask; mask != 0;
+             mask &= mask - 1) {
+            unsigned int bit = map_firstDirection(mask);
+            struct Direction direction = map_bitDirection(bit);
+            if (cell->row + direction.deltaRow       >= map->numRows    ||
+                cell->column + direction.deltaColumn >= map->numColumns ||
+                cell->layer + direction.deltaLayer   >= map->numLayers) {
+                continue;
+            }
+            unsigned int neighborIndex =
+                graph.nodeIndex[cellIndex + map->directionOffsets[bit]];
+            if (neighborIndex != MAPGRAPH_NO_NODE &&
+                (graph.nodes[neighborIndex].tile->directionMask
+                 & ((uint32_t)1 << (MAP_NUM_DIRECTIONS - 1 - bit))) != 0) {
+                mapgraph_addNeighborToNode(&graph.arena, &graph.nodes[i],
+                                           &graph.nodes[neighborIndex]);
+                mapgraph_addNeighborToNode(&graph.arena,
+                                           &graph.nodes[neighborIndex],
+                                           &graph.nodes[i]);
             }
         }
     }
     return graph;
 }
 
+void mapgraph_compact(struct MapGraph *graph) {
+    if (graph->neighborOffsets != NULL) return;
+    uint32_t numArcs = 0;
+    for (unsigned int i = 0; i < graph->numNodes; ++i) {
+        numArcs += graph->nodes[i].numNeighbors;
+    }
+    uint32_t *offsets =
+        (uint32_t*)malloc((graph->numNodes + 1) * sizeof(uint32_t));
+    uint32_t *indices =
+        (uint32_t*)malloc((numArcs > 0 ? numArcs : 1) * sizeof(uint32_t));
+    unsigned int *lastSeen =
+        (unsigned int*)malloc((graph->numNodes > 0 ? graph->numNodes : 1)
+                              * sizeof(unsigned int));
+    for (unsigned int i = 0; i < graph->numNodes; ++i) {
+        lastSeen[i] = MAPGRAPH_NO_NODE;
+    }
+    numArcs = 0;
+    for (unsigned int i = 0; i < graph->numNodes; ++i) {
+        struct MapCellNode *node = &graph->nodes[i];
+        offsets[i] = numArcs;
+        for (unsigned int j = 0; j < node->numNeighbors; ++j) {
+            unsigned int neighbor = node->neighbors[j]->index;
+            if (lastSeen[neighbor] != i) {
+                lastSeen[neighbor] = i;
+                indices[numArcs] = neighbor;
+                ++numArcs;
+            }
+        }
+        node->neighbors = NULL;
+        node->numNeighbors = numArcs - offsets[i];
+        node->capacity = 0;
+    }
+    offsets[graph->numNodes] = numArcs;
+    free(lastSeen);
+    arena_delete(&graph->arena);
+    graph->neighborOffsets = offsets;
+    graph->neighborIndices = indices;
+    graph->numArcs = numArcs;
+}
+
+void mapgraph_labelComponents(struct MapGraph *graph) {
+    bool *labeled = (bool*)calloc(graph->numNodes > 0 ? graph->numNodes : 1,
+                                  sizeof(bool));
+    Queue queue = queue_createWithCapacity(graph->numNodes);
+    unsigned int numComponents = 0;
+    for (unsigned int i = 0; i < graph->numNodes; ++i) {
+        if (labeled[i]) continue;
+        labeled[i] = true;
+        graph->nodes[i].component = numComponents;
+        queue_enqueue(&queue, &graph->nodes[i], 0);
+        while (!queue_isEmpty(&queue)) {
+            struct MapCellNode *node = queue_dequeue(&queue).cell;
+            unsigned int numNeighbors = mapgraph_numNeighbors(graph, node->index);
+            for (unsigned int j = 0; j < numNeighbors; ++j) {
+                unsigned int index = mapgraph_getNeighbor(graph, node->index, j);
+                if (!labeled[index]) {
+                    labeled[index] = true;
+                    graph->nodes[index].component = numComponents;
+                    queue_enqueue(&queue, &graph->nodes[index], 0);
+                }
+            }
+        }
+        ++numComponents;
+    }
+    queue_delete(&queue);
+    free(labeled);
+    graph->numComponents = numComponents;
+}
+
+bool mapgraph_areConnected(const struct MapGraph *graph,
+                           const struct MapCell *start,
+                           const struct MapCell *end) {
+    if (graph->numComponents == 0) {
+        return true;
+    } else {
+        return mapgraph_getNode(graph, start)->component ==
+               mapgraph_getNode(graph, end)->component;
+    }
+}
+
+unsigned int mapgraph_numNeighbors(const struct MapGraph *graph,
+                                   unsigned int index) {
+    if (graph->neighborOffsets != NULL) {
+        return graph->neighborOffsets[index + 1] - graph->neighborOffsets[index];
+    } else {
+        return graph->nodes[index].numNeighbors;
+    }
+}
+
+unsigned int mapgraph_getNeighbor(const struct MapGraph *graph,
+                                  unsigned int index,
+                                  unsigned int j) {
+    if (graph->neighborOffsets != NULL) {
+        return graph->neighborIndices[graph->neighborOffsets[index] + j];
+    } else {
+        return graph->nodes[index].neighbors[j]->index;
+    }
+}
+
 void mapgraph_delete(struct MapGraph *graph) {
+    arena_delete(&graph->arena);
     free(graph->nodes);
+    free(graph->nodeIndex);
+    free(graph->neighborOffsets);
+    free(graph->neighborIndices);
 }
 
 void mapgraph_print(const struct MapGraph *graph) {
     printf("Map graph of %d nodes\n", graph->numNodes);
     for (unsigned int i = 0; i < graph->numNodes; ++i) {
-        mapgraph_printNode(&graph->nodes[i]);
+        mapgraph_printNode(&graph->nodes[i], graph->numComponents > 0);
     }
 }
 
@@ -197,32 +556,29 @@ void mapgraph_toDot(const struct MapGraph *graph,
     fprintf(outputFile, "strict graph {\n");
     for (unsigned int k = 0; k < graph->map->numLayers; ++k) {
         for (unsigned int i = 0; i < graph->numNodes; ++i) {
-            if (graph->nodes[i].cell.layer == k) {
-                if (graph->map->layers[k].highlight[graph->nodes[i].cell.row][graph->nodes[i].cell.column]){
-                    fprintf(outputFile, "  \"%d,%d,%d\" [style=filled fillcolor=yellow label=\"(%d,%d,%d)\"];\n",
-                                        graph->nodes[i].cell.layer,
-                                        graph->nodes[i].cell.row,
-                                        graph->nodes[i].cell.column,
-                                        graph->nodes[i].cell.layer,
-                                        graph->nodes[i].cell.row,
-                                        graph->nodes[i].cell.column);    
-                } else if (graph->map->layers[k].highlight[graph->nodes[i].cell.row][graph->nodes[i].cell.column]==false) {
-                    fprintf(outputFile, "  \"%d,%d,%d\" [label=\"(%d,%d,%d)\"];\n",
-                                    graph->nodes[i].cell.layer,
-                                    graph->nodes[i].cell.row,
-                                    graph->nodes[i].cell.column,
-                                    graph->nodes[i].cell.layer,
-                                    graph->nodes[i].cell.row,
-                                    graph->nodes[i].cell.column);
+            const struct MapCell *cell = &graph->nodes[i].cell;
+            if (cell->layer == k) {
+                fprintf(outputFile, "  \"%d,%d,%d\" [",
+                                    cell->layer, cell->row, cell->column);
+                if (map_isHighlighted(graph->map, k, cell->row, cell->column)) {
+                    fprintf(outputFile, "style=filled fillcolor=yellow ");
+                }
+                if (graph->numComponents > 0) {
+                    fprintf(outputFile, "component=%d ",
+                                        graph->nodes[i].component);
                 }
+                fprintf(outputFile, "label=\"(%d,%d,%d)\"];\n",
+                                    cell->layer, cell->row, cell->column);
             }
         }
     }
 
    for (unsigned int i = 0; i < graph->numNodes; ++i) {
-        for (unsigned int j = 0; j < graph->nodes[i].numNeighbors; ++j) {
+        unsigned int numNeighbors = mapgraph_numNeighbors(graph, i);
+        for (unsigned int j = 0; j < numNeighbors; ++j) {
             struct MapCell *cell = &graph->nodes[i].cell;
-            struct MapCell *neighbor = &graph->nodes[i].neighbors[j]->cell;
+            struct MapCell *neighbor =
+                &graph->nodes[mapgraph_getNeighbor(graph, i, j)].cell;
             fprintf(outputFile, "  \"%d,%d,%d\" -- \"%d,%d,%d\";\n",
                                 cell->layer, cell->row, cell->column,
                                 neighbor->layer, neighbor->row, neighbor->column);
@@ -235,6 +591,11 @@ void mapgraph_toDot(const struct MapGraph *graph,
     }
 }
 
+bool mapgraph_hasCell(const struct MapGraph *graph,
+                      const struct MapCell *cell) {
+    return mapgraph_getNode(graph, cell) != NULL;
+}
+
 struct MapGraphPath *mapgraph_retrievePath(struct MapCellNode **predecessors,
                                            unsigned int startIndex,
                                            unsigned int endIndex,
@@ -242,17 +603,16 @@ struct MapGraphPath *mapgraph_retrievePath(struct MapCellNode **predecessors,
     if (predecessors[endIndex] == NULL) {
         return NULL;
     } else {
+        unsigned int numCells = 1;
+        for (unsigned int index = endIndex; index != startIndex;
+             index = predecessors[index]->index) {
+            ++numCells;
+        }
+        struct MapGraphPath *path = mapgraph_createPath(numCells);
         unsigned int index = endIndex;
-        struct MapGraphPath *path =
-            (struct MapGraphPath*)malloc(sizeof(struct MapGraphPath));
-        path->head = *endCell;
-        path->tail = NULL;
-        while (index != startIndex) {
-            struct MapGraphPath *tmpPath =
-                (struct MapGraphPath*)malloc(sizeof(struct MapGraphPath));
-            tmpPath->head = predecessors[index]->cell;
-            tmpPath->tail = path;
-            path = tmpPath;
+        path->cells[numCells - 1] = *endCell;
+        for (unsigned int i = numCells - 1; i > 0; --i) {
+            path->cells[i - 1] = predecessors[index]->cell;
             index = predecessors[index]->index;
         }
         return path;
@@ -262,62 +622,457 @@ struct MapGraphPath *mapgraph_retrievePath(struct MapCellNode **predecessors,
 struct MapGraphPath *mapgraph_shortestPath(const struct MapGraph *graph,
                                            const struct MapCell *start,
                                            const struct MapCell *end) {
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    struct MapGraphSearch search = mapgraph_createSearch(graph);
+    struct MapGraphPath *path = mapgraph_searchShortestPath(&search, start, end);
+    mapgraph_deleteSearch(&search);
+    return path;
+}
+
+struct MapGraphSearch mapgraph_createSearch(const struct MapGraph *graph) {
+    struct MapGraphSearch search;
+    search.graph = graph;
+    search.predecessors =
+        (struct MapCellNode**)malloc(graph->numNodes * sizeof(struct MapCellNode*));
+    search.distance =
+        (int*)malloc(graph->numNodes * sizeof(int));
+    search.generations =
+        (unsigned int*)calloc(graph->numNodes, sizeof(unsigned int));
+    search.generation = 0;
+    search.queue = queue_createWithCapacity(graph->numNodes);
+    return search;
+}
+
+void mapgraph_deleteSearch(struct MapGraphSearch *search) {
+    free(search->predecessors);
+    free(search->distance);
+    free(search->generations);
+    queue_delete(&search->queue);
+    search->predecessors = NULL;
+    search->distance = NULL;
+    search->generations = NULL;
+}
+
+unsigned int mapgraph_nextGeneration(struct MapGraphSearch *search) {
+    if (++search->generation == 0) {
+        for (unsigned int i = 0; i < search->graph->numNodes; ++i) {
+            search->generations[i] = 0;
+        }
+        search->generation = 1;
+    }
+    return search->generation;
+}
+
+struct MapGraphPath *mapgraph_searchShortestPath(struct MapGraphSearch *search,
+                                                 const struct MapCell *start,
+                                                 const struct MapCell *end) {
+    const struct MapGraph *graph = search->graph;
     assert(start->row    < graph->map->numRows);
     assert(start->column < graph->map->numColumns);
     assert(start->layer  < graph->map->numLayers);
     assert(end->row      < graph->map->numRows);
     assert(end->column   < graph->map->numColumns);
     assert(end->layer    < graph->map->numLayers);
-    struct MapCellNode **predecessors =
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    struct MapCellNode *startNode = mapgraph_getNode(graph, start);
+    struct MapCellNode *endNode = mapgraph_getNode(graph, end);
+    if (mapgraph_breadthFirstSearch(search, &startNode, 1,
+                                    endNode, NULL, -1) == NULL) {
+        return NULL;
+    } else {
+        return mapgraph_retrievePath(search->predecessors,
+                                     startNode->index,
+                                     endNode->index,
+                                     end);
+    }
+}
+
+struct MapGraphPath *mapgraph_searchShortestPathAStar(struct MapGraphSearch *search,
+                                                      const struct MapCell *start,
+                                                      const struct MapCell *end) {
+    const struct MapGraph *graph = search->graph;
+    assert(start->row    < graph->map->numRows);
+    assert(start->column < graph->map->numColumns);
+    assert(start->layer  < graph->map->numLayers);
+    assert(end->row      < graph->map->numRows);
+    assert(end->column   < graph->map->numColumns);
+    assert(end->layer    < graph->map->numLayers);
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    unsigned int generation = mapgraph_nextGeneration(search);
+    struct MapCellNode *startNode = mapgraph_getNode(graph, start);
+    struct MapCellNode *endNode = mapgraph_getNode(graph, end);
+    Heap heap = heap_create(64);
+    heap_push(&heap, startNode, mapgraph_estimateDistance(start, end));
+    search->generations[startNode->index] = generation;
+    search->distance[startNode->index] = 0;
+    search->predecessors[startNode->index] = startNode;
+    while (!heap_isEmpty(&heap)) {
+        struct QueueContent content = heap_pop(&heap);
+        struct MapCellNode *node = content.cell;
+        if (content.priority > search->distance[node->index] +
+            mapgraph_estimateDistance(&node->cell, end)) {
+            continue;
+        }
+        if (node == endNode) break;
+        unsigned int numNeighbors = mapgraph_numNeighbors(graph, node->index);
+        for (unsigned int i = 0; i < numNeighbors; ++i) {
+            unsigned int index = mapgraph_getNeighbor(graph, node->index, i);
+            int neighborDistance = search->distance[node->index] + 1;
+            if (search->generations[index] != generation ||
+                neighborDistance < search->distance[index]) {
+                search->generations[index] = generation;
+                search->distance[index] = neighborDistance;
+                search->predecessors[index] = node;
+                heap_push(&heap, &graph->nodes[index],
+                          neighborDistance +
+                          mapgraph_estimateDistance(&graph->nodes[index].cell,
+                                                    end));
+            }
+        }
+    }
+    heap_delete(&heap);
+    return mapgraph_pathFromSource(search, end);
+}
+
+void mapgraph_searchFrom(struct MapGraphSearch *search,
+                         const struct MapCell *start) {
+    struct MapCellNode *startNode = mapgraph_getNode(search->graph, start);
+    if (startNode == NULL) {
+        mapgraph_nextGeneration(search);
+    } else {
+        mapgraph_breadthFirstSearch(search, &startNode, 1, NULL, NULL, -1);
+    }
+}
+
+struct MapGraphPath *mapgraph_searchNearest(struct MapGraphSearch *search,
+                                            const struct MapCell *start,
+                                            const char *tileName) {
+    const struct MapGraph *graph = search->graph;
+    struct MapCellNode *startNode = mapgraph_getNode(graph, start);
+    bool *targetTiles = mapgraph_tilesNamed(graph->map, tileName);
+    struct MapGraphPath *path = NULL;
+    if (startNode != NULL && targetTiles != NULL) {
+        const struct MapCellNode *goal =
+            mapgraph_breadthFirstSearch(search, &startNode, 1,
+                                        NULL, targetTiles, -1);
+        if (goal != NULL) {
+            path = mapgraph_retrievePath(search->predecessors,
+                                         startNode->index,
+                                         goal->index,
+                                         &goal->cell);
+        }
+    }
+    free(targetTiles);
+    return path;
+}
+
+void mapgraph_searchFromTiles(struct MapGraphSearch *search,
+                              const char *tileName) {
+    const struct MapGraph *graph = search->graph;
+    bool *sourceTiles = mapgraph_tilesNamed(graph->map, tileName);
+    struct MapCellNode **startNodes =
         (struct MapCellNode**)malloc(graph->numNodes * sizeof(struct MapCellNode*));
-    int *distance =
-        (int*)malloc(graph->numNodes * sizeof(int));
-    for (unsigned int i = 0; i < graph->numNodes; ++i) {
-        predecessors[i] = NULL;
-        distance[i] = -1;
-    }
-    struct MapCellNode *startNode =
-        mapgraph_getNode(graph, start);
-    Queue queue = queue_create();
-    queue_enqueue(&queue, startNode, 0);
-    distance[startNode->index] = 0;
-    predecessors[startNode->index] = startNode;
-    while (!queue_isEmpty(&queue)) {
-        struct QueueContent content = queue_dequeue(&queue);
-        for (unsigned int i = 0; i < content.cell->numNeighbors; ++i) {
-            struct MapCellNode *neighbor = content.cell->neighbors[i];
-            unsigned int index = neighbor->index;
-            if (distance[index] == -1) {
-                distance[index] = content.priority + 1;
-                predecessors[index] = content.cell;
-                queue_enqueue(&queue, neighbor, content.priority + 1);
+    unsigned int numStartNodes = 0;
+    for (unsigned int i = 0; sourceTiles != NULL && i < graph->numNodes; ++i) {
+        if (sourceTiles[graph->nodes[i].tile - graph->map->tiles]) {
+            startNodes[numStartNodes++] = &graph->nodes[i];
+        }
+    }
+    mapgraph_breadthFirstSearch(search, startNodes, numStartNodes,
+                                NULL, NULL, -1);
+    free(startNodes);
+    free(sourceTiles);
+}
+
+struct MapGraphPath *mapgraph_pathToSource(const struct MapGraphSearch *search,
+                                           const struct MapCell *cell) {
+    const struct MapCellNode *node = mapgraph_getNode(search->graph, cell);
+    if (node == NULL || search->generations[node->index] != search->generation) {
+        return NULL;
+    }
+    struct MapGraphPath *path =
+        mapgraph_createPath(search->distance[node->index] + 1);
+    for (unsigned int i = 0; i < path->numCells; ++i) {
+        path->cells[i] = node->cell;
+        node = search->predecessors[node->index];
+    }
+    return path;
+}
+
+struct MapGraphPath *mapgraph_pathFromSource(const struct MapGraphSearch *search,
+                                             const struct MapCell *cell) {
+    const struct MapCellNode *node = mapgraph_getNode(search->graph, cell);
+    if (node == NULL || search->generations[node->index] != search->generation) {
+        return NULL;
+    }
+    unsigned int numCells = 1;
+    for (const struct MapCellNode *previous = node;
+         search->predecessors[previous->index] != previous;
+         previous = search->predecessors[previous->index]) {
+        ++numCells;
+    }
+    struct MapGraphPath *path = mapgraph_createPath(numCells);
+    for (unsigned int i = numCells; i > 0; --i) {
+        path->cells[i - 1] = node->cell;
+        node = search->predecessors[node->index];
+    }
+    return path;
+}
+
+struct MapGraphRange *mapgraph_searchWithin(struct MapGraphSearch *search,
+                                            const struct MapCell *start,
+                                            unsigned int maxMoves) {
+    struct MapCellNode *startNode = mapgraph_getNode(search->graph, start);
+    unsigned int numCells = 0;
+    if (startNode == NULL) {
+        mapgraph_nextGeneration(search);
+    } else {
+        mapgraph_breadthFirstSearch(search, &startNode, 1,
+                                    NULL, NULL, (int)maxMoves);
+        numCells = search->queue.head + search->queue.numNodes;
+    }
+    struct MapGraphRange *range =
+        (struct MapGraphRange*)malloc(sizeof(struct MapGraphRange)
+                                      + numCells * sizeof(struct MapCell));
+    range->numCells = numCells;
+    for (unsigned int i = 0; i < numCells; ++i) {
+        range->cells[i] = search->queue.buffer[i].cell->cell;
+    }
+    return range;
+}
+
+struct MapGraphRange *mapgraph_cellsWithin(const struct MapGraph *graph,
+                                           const struct MapCell *start,
+                                           unsigned int maxMoves) {
+    struct MapGraphSearch search = mapgraph_createSearch(graph);
+    struct MapGraphRange *range = mapgraph_searchWithin(&search, start, maxMoves);
+    mapgraph_deleteSearch(&search);
+    return range;
+}
+
+void mapgraph_deleteRange(struct MapGraphRange *range) {
+    free(range);
+}
+
+struct MapGraphPath *mapgraph_shortestPathToNearest(const struct MapGraph *graph,
+                                                    const struct MapCell *start,
+                                                    const char *tileName) {
+    struct MapGraphSearch search = mapgraph_createSearch(graph);
+    struct MapGraphPath *path = mapgraph_searchNearest(&search, start, tileName);
+    mapgraph_deleteSearch(&search);
+    return path;
+}
+
+unsigned int mapgraph_estimateDistance(const struct MapCell *cell,
+                                       const struct MapCell *end) {
+    unsigned int deltaRow = cell->row > end->row ?
+        cell->row - end->row : end->row - cell->row;
+    unsigned int deltaColumn = cell->column > end->column ?
+        cell->column - end->column : end->column - cell->column;
+    unsigned int deltaLayer = cell->layer > end->layer ?
+        cell->layer - end->layer : end->layer - cell->layer;
+    unsigned int estimate = deltaRow;
+    if (deltaColumn > estimate) estimate = deltaColumn;
+    if (deltaLayer > estimate)  estimate = deltaLayer;
+    return estimate;
+}
+
+struct MapGraphPath *mapgraph_shortestPathAStar(const struct MapGraph *graph,
+                                                const struct MapCell *start,
+                                                const struct MapCell *end) {
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    struct MapGraphSearch search = mapgraph_createSearch(graph);
+    struct MapGraphPath *path =
+        mapgraph_searchShortestPathAStar(&search, start, end);
+    mapgraph_deleteSearch(&search);
+    return path;
+}
+
+struct MapGraphPath *mapgraph_shortestPathBidirectional(const struct MapGraph *graph,
+                                                        const struct MapCell *start,
+                                                        const struct MapCell *end) {
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    struct MapGraphSearch forward = mapgraph_createSearch(graph);
+    struct MapGraphSearch backward = mapgraph_createSearch(graph);
+    struct MapGraphPath *path =
+        mapgraph_searchShortestPathBidirectional(&forward, &backward,
+                                                 start, end);
+    mapgraph_deleteSearch(&forward);
+    mapgraph_deleteSearch(&backward);
+    return path;
+}
+
+struct MapGraphPath *mapgraph_searchShortestPathBidirectional(struct MapGraphSearch *forward,
+                                                              struct MapGraphSearch *backward,
+                                                              const struct MapCell *start,
+                                                              const struct MapCell *end) {
+    const struct MapGraph *graph = forward->graph;
+    assert(backward->graph == graph && backward != forward);
+    assert(start->row    < graph->map->numRows);
+    assert(start->column < graph->map->numColumns);
+    assert(start->layer  < graph->map->numLayers);
+    assert(end->row      < graph->map->numRows);
+    assert(end->column   < graph->map->numColumns);
+    assert(end->layer    < graph->map->numLayers);
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    struct MapCellNode *startNode = mapgraph_getNode(graph, start);
+    struct MapCellNode *endNode = mapgraph_getNode(graph, end);
+    unsigned int forwardGeneration = mapgraph_nextGeneration(forward);
+    unsigned int backwardGeneration = mapgraph_nextGeneration(backward);
+    queue_clear(&forward->queue);
+    queue_clear(&backward->queue);
+    queue_enqueue(&forward->queue, startNode, 0);
+    queue_enqueue(&backward->queue, endNode, 0);
+    forward->generations[startNode->index] = forwardGeneration;
+    backward->generations[endNode->index] = backwardGeneration;
+    forward->distance[startNode->index] = 0;
+    backward->distance[endNode->index] = 0;
+    forward->predecessors[startNode->index] = startNode;
+    backward->predecessors[endNode->index] = endNode;
+    int bestLength = -1;
+    unsigned int meetingIndex = MAPGRAPH_NO_NODE;
+    if (startNode == endNode) {
+        bestLength = 0;
+        meetingIndex = startNode->index;
+    }
+    while (bestLength == -1 &&
+           !queue_isEmpty(&forward->queue) &&
+           !queue_isEmpty(&backward->queue)) {
+        if (forward->queue.numNodes <= backward->queue.numNodes) {
+            mapgraph_expandLevel(forward, backward, &bestLength, &meetingIndex);
+        } else {
+            mapgraph_expandLevel(backward, forward, &bestLength, &meetingIndex);
+        }
+    }
+    struct MapGraphPath *path = NULL;
+    if (meetingIndex != MAPGRAPH_NO_NODE) {
+        unsigned int meetingDistance =
+            (unsigned int)forward->distance[meetingIndex];
+        path = mapgraph_createPath((unsigned int)bestLength + 1);
+        unsigned int index = meetingIndex;
+        for (unsigned int i = meetingDistance; i > 0; --i) {
+            index = forward->predecessors[index]->index;
+            path->cells[i - 1] = graph->nodes[index].cell;
+        }
+        index = meetingIndex;
+        path->cells[meetingDistance] = graph->nodes[index].cell;
+        for (unsigned int i = meetingDistance + 1; i < path->numCells; ++i) {
+            index = backward->predecessors[index]->index;
+            path->cells[i] = graph->nodes[index].cell;
+        }
+    }
+    return path;
+}
+
+struct MapGraphPath *mapgraph_shortestPathDijkstra(const struct MapGraph *graph,
+                                                   const struct MapCell *start,
+                                                   const struct MapCell *end) {
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    struct MapGraphSearch search = mapgraph_createSearch(graph);
+    struct MapGraphPath *path =
+        mapgraph_searchShortestPathDijkstra(&search, start, end);
+    mapgraph_deleteSearch(&search);
+    return path;
+}
+
+struct MapGraphPath *mapgraph_searchShortestPathDijkstra(struct MapGraphSearch *search,
+                                                         const struct MapCell *start,
+                                                         const struct MapCell *end) {
+    const struct MapGraph *graph = search->graph;
+    assert(start->row    < graph->map->numRows);
+    assert(start->column < graph->map->numColumns);
+    assert(start->layer  < graph->map->numLayers);
+    assert(end->row      < graph->map->numRows);
+    assert(end->column   < graph->map->numColumns);
+    assert(end->layer    < graph->map->numLayers);
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    unsigned int generation = mapgraph_nextGeneration(search);
+    struct MapCellNode *startNode = mapgraph_getNode(graph, start);
+    struct MapCellNode *endNode = mapgraph_getNode(graph, end);
+    RadixHeap heap = radixheap_create();
+    radixheap_push(&heap, startNode, 0);
+    search->generations[startNode->index] = generation;
+    search->distance[startNode->index] = 0;
+    search->predecessors[startNode->index] = startNode;
+    while (!radixheap_isEmpty(&heap)) {
+        struct QueueContent content = radixheap_pop(&heap);
+        struct MapCellNode *node = content.cell;
+        if (content.priority > (unsigned int)search->distance[node->index]) {
+            continue;
+        }
+        if (node == endNode) break;
+        unsigned int numNeighbors = mapgraph_numNeighbors(graph, node->index);
+        for (unsigned int i = 0; i < numNeighbors; ++i) {
+            unsigned int index = mapgraph_getNeighbor(graph, node->index, i);
+            unsigned int neighborDistance =
+                content.priority + graph->nodes[index].tile->cost;
+            if (search->generations[index] != generation ||
+                neighborDistance < (unsigned int)search->distance[index]) {
+                search->generations[index] = generation;
+                search->distance[index] = (int)neighborDistance;
+                search->predecessors[index] = node;
+                radixheap_push(&heap, &graph->nodes[index], neighborDistance);
             }
         }
     }
+    radixheap_delete(&heap);
+    return mapgraph_pathFromSource(search, end);
+}
+
+struct MapGraphPath *mapgraph_shortestPathWith(const struct MapGraph *graph,
+                                               const struct MapCell *start,
+                                               const struct MapCell *end,
+                                               enum MapGraphAlgorithm algorithm) {
+    switch (algorithm) {
+        case MAPGRAPH_ASTAR:
+            return mapgraph_shortestPathAStar(graph, start, end);
+        case MAPGRAPH_BIDIRECTIONAL:
+            return mapgraph_shortestPathBidirectional(graph, start, end);
+        case MAPGRAPH_DIJKSTRA:
+            return mapgraph_shortestPathDijkstra(graph, start, end);
+        case MAPGRAPH_BFS:
+        default:
+            assert(algorithm == MAPGRAPH_BFS);
+            return mapgraph_shortestPath(graph, start, end);
+    }
+}
+
+struct MapGraphPath *mapgraph_createPath(unsigned int numCells) {
     struct MapGraphPath *path =
-        mapgraph_retrievePath(predecessors,
-                              startNode->index,
-                              mapgraph_getNode(graph, end)->index,
-                              end);
-    free(predecessors);
-    free(distance);
+        (struct MapGraphPath*)malloc(sizeof(struct MapGraphPath)
+                                     + numCells * sizeof(struct MapCell));
+    path->numCells = numCells;
     return path;
 }
 
 void mapgraph_printPath(const struct MapGraphPath *path) {
-    printf("[ ");
-    while (path != NULL) {
-        printf("(%d,%d,%d) ", path->head.row,
-                             path->head.column,
-                             path->head.layer);
-        path = path->tail;
+    mapgraph_writePath(stdout, path);
+}
+
+void mapgraph_writePath(FILE *outputFile, const struct MapGraphPath *path) {
+    fprintf(outputFile, "[ ");
+    for (unsigned int i = 0; path != NULL && i < path->numCells; ++i) {
+        fprintf(outputFile, "(%d,%d,%d) ", path->cells[i].row,
+                                          path->cells[i].column,
+                                          path->cells[i].layer);
     }
-    printf("]");
+    fprintf(outputFile, "]");
 }
 
-void mapgraph_deletePath(struct MapGraphPath *path) {
-    if (path != NULL) {
-        mapgraph_deletePath(path->tail);
-        free(path);
+int mapgraph_pathLength(const struct MapGraphPath *path) {
+    return path == NULL ? -1 : (int)path->numCells - 1;
+}
+
+int mapgraph_pathCost(const struct MapGraph *graph,
+                      const struct MapGraphPath *path) {
+    if (path == NULL) return -1;
+    int cost = 0;
+    for (unsigned int i = 1; i < path->numCells; ++i) {
+        cost += mapgraph_getNode(graph, &path->cells[i])->tile->cost;
     }
+    return cost;
+}
+
+void mapgraph_deletePath(struct MapGraphPath *path) {
+    free(path);
 }
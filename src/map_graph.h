@@ -14,13 +14,28 @@
  * interest of representing a map by a graph is that one can, in particular,
  * compute a path between two cells in the map.
  *
- * The module provides four data structures:
+ * The module provides six data structures:
  *
  * - ``struct MapCell``, representing a cell in the map;
  * - ``struct MapCellNode``, representing a node in the graph;
  * - ``struct MapGraph``, representing the graph of a map;
  * - ``struct MapGraphPath``, representing a path from one cell to another in
- *   the graph.
+ *   the graph, stored with its cells in a single allocation;
+ * - ``struct MapGraphRange``, representing the cells within some moves of a
+ *   cell, stored in a single allocation;
+ * - ``struct MapGraphSearch``, representing the memory needed by a search in
+ *   the graph, which can be reused from one search to the next.
+ *
+ * The neighbors of the nodes are first stored in one growing array per node.
+ * Once the graph is built, it can be compacted into a compressed sparse row
+ * (CSR) layout: the neighbors of node ``i`` are then the indices
+ * ``neighborIndices[neighborOffsets[i]]`` to
+ * ``neighborIndices[neighborOffsets[i + 1] - 1]``, without duplicates. The
+ * functions ``mapgraph_numNeighbors`` and ``mapgraph_getNeighbor`` hide which
+ * layout is currently in use.
+ *
+ * The nodes can also be labeled by their connected component. Two cells are
+ * then known to be disconnected without any search.
  *
  * @author   Alexandre Blondin Massé
  * @version  1.0
@@ -30,7 +45,13 @@
 #define MAP_GRAPH_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "arena.h"
 #include "map.h"
+#include "queue.h"
+
+#define MAPGRAPH_NO_NODE ((unsigned int)-1) // Index of a cell without node
 
 // --------------- //
 // Data structures //
@@ -49,6 +70,7 @@ struct MapCellNode {                // A node in the map graph
     struct MapCellNode **neighbors; // The neighbors of the node
     unsigned int numNeighbors;      // The number of neighbors of the node
     unsigned int capacity;          // The capacity of the node
+    unsigned int component;         // The connected component of the node
 };
 
 struct MapGraph {              // A map graph
@@ -56,11 +78,48 @@ struct MapGraph {              // A map graph
     struct MapCellNode *nodes; // The nodes in the graph
     unsigned int numNodes;     // The number of nodes
     unsigned int capacity;     // The capacity of the graph
+    unsigned int *nodeIndex;   // The node index of each (layer,row,column)
+                               // cell, or MAPGRAPH_NO_NODE if not free
+    uint32_t *neighborOffsets; // The CSR offsets (NULL if not compacted)
+    uint32_t *neighborIndices; // The CSR neighbor indices (NULL if not
+                               // compacted)
+    uint32_t numArcs;          // The number of entries in neighborIndices
+    unsigned int numComponents; // The number of connected components (0 if
+                                // not labeled)
+    unsigned int version;      // The version of the map from which the
+                               // graph was built
+    struct Arena arena;        // The memory of the neighbor arrays of the
+                               // nodes (empty once compacted)
+};
+
+enum MapGraphAlgorithm {    // An algorithm computing shortest paths
+    MAPGRAPH_BFS,           // Breadth-first search from the start cell
+    MAPGRAPH_ASTAR,         // A* search guided towards the end cell
+    MAPGRAPH_BIDIRECTIONAL, // Breadth-first searches from both cells
+    MAPGRAPH_IMPLICIT,      // Breadth-first search on the map itself
+    MAPGRAPH_HIERARCHICAL,  // Search between the entrances of map chunks
+    MAPGRAPH_DIJKSTRA,      // Dijkstra's algorithm, using the tile costs
+    MAPGRAPH_ALT,           // A* search guided by landmark distances
+};
+
+struct MapGraphPath {       // A path in a map graph
+    unsigned int numCells;  // The number of cells in the path
+    struct MapCell cells[]; // The cells, from the first to the last
+};
+
+struct MapGraphRange {      // The cells within some moves of a cell
+    unsigned int numCells;  // The number of cells
+    struct MapCell cells[]; // The cells, by nondecreasing number of moves
 };
 
-struct MapGraphPath {          // A path in a map graph
-    struct MapCell head;       // The first cell in the path
-    struct MapGraphPath *tail; // The rest of the path
+struct MapGraphSearch {                // A search workspace on a map graph
+    const struct MapGraph *graph;      // The searched graph
+    struct MapCellNode **predecessors; // The predecessor of each node
+    int *distance;                     // The distance of each node
+    unsigned int *generations;         // The search that last visited each
+                                       // node
+    unsigned int generation;           // The number of the current search
+    Queue queue;                       // The queue of the nodes to visit
 };
 
 // --------- //
@@ -79,6 +138,68 @@ struct MapGraphPath {          // A path in a map graph
  */
 struct MapGraph mapgraph_create(const struct Map *map);
 
+/**
+ * Compacts the neighbors of the given graph into a CSR layout.
+ *
+ * The neighbor arrays of the nodes are released at once, with the arena
+ * from which they were allocated, and replaced by a single array of offsets
+ * and a single array of 32-bit neighbor indices, in which duplicate edges
+ * are removed. The order of the neighbors is preserved.
+ * Compacting an already compacted graph does nothing.
+ *
+ * @param graph  The graph to compact
+ */
+void mapgraph_compact(struct MapGraph *graph);
+
+/**
+ * Labels each node of the given graph with its connected component.
+ *
+ * The components are numbered from 0 in the order of their first node. Once
+ * a graph is labeled, every search between two cells of different components
+ * returns NULL immediately. The labels are also included when the graph is
+ * printed or written to a dot file.
+ *
+ * @param graph  The graph to label
+ */
+void mapgraph_labelComponents(struct MapGraph *graph);
+
+/**
+ * Returns true if there might be a path between the two given cells.
+ *
+ * If the components of the graph are labeled, the answer is exact. Otherwise,
+ * true is returned.
+ *
+ * @param graph  The graph
+ * @param start  The starting cell, which must be a node of the graph
+ * @param end    The ending cell, which must be a node of the graph
+ * @return       False if the cells are known to be disconnected
+ */
+bool mapgraph_areConnected(const struct MapGraph *graph,
+                           const struct MapCell *start,
+                           const struct MapCell *end);
+
+/**
+ * Returns the number of neighbors of the given node.
+ *
+ * @param graph  The graph
+ * @param index  The index of the node
+ * @return       The number of neighbors of the node
+ */
+unsigned int mapgraph_numNeighbors(const struct MapGraph *graph,
+                                   unsigned int index);
+
+/**
+ * Returns the index of the j-th neighbor of the given node.
+ *
+ * @param graph  The graph
+ * @param index  The index of the node
+ * @param j      The rank of the neighbor, in [0, numNeighbors)
+ * @return       The index of the neighbor
+ */
+unsigned int mapgraph_getNeighbor(const struct MapGraph *graph,
+                                  unsigned int index,
+                                  unsigned int j);
+
 /**
  * Deletes the given graph.
  *
@@ -105,6 +226,19 @@ void mapgraph_print(const struct MapGraph *graph);
 void mapgraph_toDot(const struct MapGraph *graph,
                     const char *outputFilename);
 
+/**
+ * Returns true if the given cell is a node of the graph.
+ *
+ * In other words, the cell belongs to the map, is not empty and has no tile
+ * above itself.
+ *
+ * @param graph  The graph
+ * @param cell   The cell to be checked
+ * @return       True if the cell is a node of the graph
+ */
+bool mapgraph_hasCell(const struct MapGraph *graph,
+                      const struct MapCell *cell);
+
 /**
  * Returns a shortest path between two cells in the given graph.
  *
@@ -122,6 +256,362 @@ struct MapGraphPath *mapgraph_shortestPath(const struct MapGraph *graph,
                                            const struct MapCell *start,
                                            const struct MapCell *end);
 
+/**
+ * Creates a search workspace for the given graph.
+ *
+ * The workspace holds every buffer proportional to the graph that is needed
+ * by a breadth-first search, A* or Dijkstra's algorithm (a bidirectional BFS
+ * needs two workspaces), so that many searches can be done without
+ * allocating them again. A workspace must not be shared between threads, but
+ * each thread can own its own workspace on the same graph.
+ *
+ * The buffers are never cleared between two searches: each search has its
+ * own generation number, and the distance and the predecessor of a node are
+ * only meaningful if the node is stamped with the current generation. Hence,
+ * the cost of a search only depends on the number of nodes it visits, not on
+ * the size of the graph.
+ *
+ * @param graph  The graph to be searched
+ * @return       The workspace
+ */
+struct MapGraphSearch mapgraph_createSearch(const struct MapGraph *graph);
+
+/**
+ * Deletes the given search workspace.
+ *
+ * @param search  The workspace to delete
+ */
+void mapgraph_deleteSearch(struct MapGraphSearch *search);
+
+/**
+ * Starts a new search in the given workspace.
+ *
+ * The generation number of the workspace is incremented, so that every node
+ * is considered unvisited. The stamps are only cleared when the number wraps
+ * around.
+ *
+ * @param search  The search workspace
+ * @return        The generation number of the new search
+ */
+unsigned int mapgraph_nextGeneration(struct MapGraphSearch *search);
+
+/**
+ * Returns a shortest path between two cells, using the given workspace.
+ *
+ * The result is the same as the one of ``mapgraph_shortestPath``. The search
+ * stops as soon as the ending cell is reached.
+ *
+ * @param search  The search workspace
+ * @param start   The starting cell
+ * @param end     The ending cell
+ * @return        A shortest path between two cells
+ */
+struct MapGraphPath *mapgraph_searchShortestPath(struct MapGraphSearch *search,
+                                                 const struct MapCell *start,
+                                                 const struct MapCell *end);
+
+/**
+ * Returns a shortest path between two cells, using the A* algorithm and the
+ * given workspace.
+ *
+ * The result is the same as the one of ``mapgraph_shortestPathAStar``, but
+ * the distances and predecessors are kept in the workspace. Since the
+ * estimate of A* is consistent, a node taken from the heap whose priority is
+ * larger than its current distance plus its estimate is an outdated entry
+ * and is skipped.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param search  The search workspace
+ * @param start   The starting cell
+ * @param end     The ending cell
+ * @return        A shortest path between two cells
+ */
+struct MapGraphPath *mapgraph_searchShortestPathAStar(struct MapGraphSearch *search,
+                                                      const struct MapCell *start,
+                                                      const struct MapCell *end);
+
+/**
+ * Returns a shortest path between two cells, using a bidirectional BFS and
+ * the given workspaces.
+ *
+ * The result is the same as the one of
+ * ``mapgraph_shortestPathBidirectional``. The search from the starting cell is
+ * done in the first workspace and the search from the ending cell in the
+ * second one, which must be two different workspaces on the same graph.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param forward   The workspace of the search from the starting cell
+ * @param backward  The workspace of the search from the ending cell
+ * @param start     The starting cell
+ * @param end       The ending cell
+ * @return          A shortest path between two cells
+ */
+struct MapGraphPath *mapgraph_searchShortestPathBidirectional(struct MapGraphSearch *forward,
+                                                              struct MapGraphSearch *backward,
+                                                              const struct MapCell *start,
+                                                              const struct MapCell *end);
+
+/**
+ * Returns a cheapest path between two cells, using Dijkstra's algorithm and
+ * the given workspace.
+ *
+ * The result is the same as the one of ``mapgraph_shortestPathDijkstra``. The
+ * distances of the workspace are then the costs of the visited nodes.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param search  The search workspace
+ * @param start   The starting cell
+ * @param end     The ending cell
+ * @return        A cheapest path between two cells
+ */
+struct MapGraphPath *mapgraph_searchShortestPathDijkstra(struct MapGraphSearch *search,
+                                                         const struct MapCell *start,
+                                                         const struct MapCell *end);
+
+/**
+ * Visits every node connected to a cell by a breadth-first search, using the
+ * given workspace.
+ *
+ * Once the search is done, a node has been visited if it is stamped with the
+ * current generation of the workspace, and its distance and predecessor in
+ * the workspace are then its distance to the cell and the next node of a
+ * shortest path from the node to the cell (the cell being its own
+ * predecessor). If the cell is not a node, no node is visited.
+ *
+ * @param search  The search workspace
+ * @param start   The cell from which the search starts
+ */
+void mapgraph_searchFrom(struct MapGraphSearch *search,
+                         const struct MapCell *start);
+
+/**
+ * Returns a shortest path from a cell to the closest cell whose tile has the
+ * given name, using the given workspace.
+ *
+ * A single breadth-first search is done, which stops as soon as such a cell
+ * is reached. If no such cell is connected to the starting cell, then NULL is
+ * returned.
+ *
+ * @param search    The search workspace
+ * @param start     The starting cell
+ * @param tileName  The name of the tile of the targets
+ * @return          A shortest path from the cell to the closest target
+ */
+struct MapGraphPath *mapgraph_searchNearest(struct MapGraphSearch *search,
+                                            const struct MapCell *start,
+                                            const char *tileName);
+
+/**
+ * Visits every node connected to a cell whose tile has the given name, by a
+ * single breadth-first search from all those cells at once, using the given
+ * workspace.
+ *
+ * Once the search is done, the distance of a visited node in the workspace
+ * is its distance to the closest of those cells, which
+ * ``mapgraph_pathToSource`` reaches from the node.
+ *
+ * @param search    The search workspace
+ * @param tileName  The name of the tile of the sources
+ */
+void mapgraph_searchFromTiles(struct MapGraphSearch *search,
+                              const char *tileName);
+
+/**
+ * Returns the path from a cell to the source of the last search of the given
+ * workspace, done by ``mapgraph_searchFrom`` or
+ * ``mapgraph_searchFromTiles``.
+ *
+ * The path follows the predecessors of the search, so that it is a shortest
+ * path to the closest source. If the cell was not visited, then NULL is
+ * returned.
+ *
+ * @param search  The search workspace
+ * @param cell    The cell
+ * @return        A shortest path from the cell to a source of the search
+ */
+struct MapGraphPath *mapgraph_pathToSource(const struct MapGraphSearch *search,
+                                           const struct MapCell *cell);
+
+/**
+ * Returns the path from the source of the last search of the given workspace
+ * to a cell.
+ *
+ * The path follows the predecessors of the search backwards from the cell,
+ * until a node that is its own predecessor is reached. If the cell was not
+ * visited by the last search, then NULL is returned, so that the
+ * predecessors left by an earlier search are never followed.
+ *
+ * @param search  The search workspace
+ * @param cell    The cell
+ * @return        The path from a source of the search to the cell
+ */
+struct MapGraphPath *mapgraph_pathFromSource(const struct MapGraphSearch *search,
+                                             const struct MapCell *cell);
+
+/**
+ * Returns every cell that can be reached from a cell in at most the given
+ * number of moves, using the given workspace.
+ *
+ * The breadth-first search stops expanding the nodes at that number of
+ * moves, so that its cost only depends on the size of the returned region.
+ * Once the search is done, the distance of each returned cell is also
+ * available in the workspace. If the cell is not a node, the region is
+ * empty.
+ *
+ * @param search    The search workspace
+ * @param start     The starting cell
+ * @param maxMoves  The maximum number of moves
+ * @return          The cells within the number of moves, including the
+ *                  starting cell
+ */
+struct MapGraphRange *mapgraph_searchWithin(struct MapGraphSearch *search,
+                                            const struct MapCell *start,
+                                            unsigned int maxMoves);
+
+/**
+ * Returns every cell that can be reached from a cell in at most the given
+ * number of moves.
+ *
+ * @param graph     The graph
+ * @param start     The starting cell
+ * @param maxMoves  The maximum number of moves
+ * @return          The cells within the number of moves, including the
+ *                  starting cell
+ */
+struct MapGraphRange *mapgraph_cellsWithin(const struct MapGraph *graph,
+                                           const struct MapCell *start,
+                                           unsigned int maxMoves);
+
+/**
+ * Deletes the given region.
+ *
+ * @param range  The region to delete
+ */
+void mapgraph_deleteRange(struct MapGraphRange *range);
+
+/**
+ * Returns a shortest path from a cell to the closest cell whose tile has the
+ * given name.
+ *
+ * If no such cell is connected to the starting cell, then NULL is returned.
+ *
+ * @param graph     The graph
+ * @param start     The starting cell
+ * @param tileName  The name of the tile of the targets
+ * @return          A shortest path from the cell to the closest target
+ */
+struct MapGraphPath *mapgraph_shortestPathToNearest(const struct MapGraph *graph,
+                                                    const struct MapCell *start,
+                                                    const char *tileName);
+
+/**
+ * Returns a lower bound on the number of moves between two cells.
+ *
+ * Since a single move changes the row, the column and the layer by at most
+ * one, at least as many moves as the largest of these differences are needed.
+ *
+ * @param cell  The first cell
+ * @param end   The second cell
+ * @return      A lower bound on the distance between the cells
+ */
+unsigned int mapgraph_estimateDistance(const struct MapCell *cell,
+                                       const struct MapCell *end);
+
+/**
+ * Returns a shortest path between two cells, using the A* algorithm.
+ *
+ * The search is guided by the number of moves that would be needed if every
+ * move were allowed, i.e. the largest difference between the rows, the
+ * columns and the layers of a cell and the ending cell. Since this estimate
+ * never overestimates the real distance, the returned path is as short as the
+ * one returned by ``mapgraph_shortestPath``, but usually far fewer nodes are
+ * explored.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param graph  The graph
+ * @param start  The starting cell
+ * @param end    The ending cell
+ * @return       A shortest path between two cells
+ */
+struct MapGraphPath *mapgraph_shortestPathAStar(const struct MapGraph *graph,
+                                                const struct MapCell *start,
+                                                const struct MapCell *end);
+
+/**
+ * Returns a shortest path between two cells, using a bidirectional BFS.
+ *
+ * Two breadth-first searches are run alternately, one from the starting cell
+ * and one from the ending cell, always expanding the smallest frontier by one
+ * whole level. The search stops as soon as the frontiers meet, so that only
+ * about half of the search radius is explored from each side.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param graph  The graph
+ * @param start  The starting cell
+ * @param end    The ending cell
+ * @return       A shortest path between two cells
+ */
+struct MapGraphPath *mapgraph_shortestPathBidirectional(const struct MapGraph *graph,
+                                                        const struct MapCell *start,
+                                                        const struct MapCell *end);
+
+/**
+ * Returns a cheapest path between two cells, using Dijkstra's algorithm.
+ *
+ * Moving onto a cell costs the ``cost`` of its tile, so that the returned
+ * path minimizes the total cost of its moves rather than their number. The
+ * other algorithms ignore the costs. The nodes to visit are kept in a radix
+ * heap, which is faster than a binary heap since the costs are integers.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param graph  The graph
+ * @param start  The starting cell
+ * @param end    The ending cell
+ * @return       A cheapest path between two cells
+ */
+struct MapGraphPath *mapgraph_shortestPathDijkstra(const struct MapGraph *graph,
+                                                   const struct MapCell *start,
+                                                   const struct MapCell *end);
+
+/**
+ * Returns a shortest path between two cells, using the given algorithm.
+ *
+ * Only the algorithms searching the graph alone are available: the search
+ * without graph is done on the map by ``mapsearch_shortestPath``, while
+ * hierarchical search and ALT search need the chunks or the landmarks of the
+ * graph, which are kept by the caller (see ``maphierarchy_shortestPath`` and
+ * ``maplandmarks_shortestPath``).
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param graph      The graph
+ * @param start      The starting cell
+ * @param end        The ending cell
+ * @param algorithm  The algorithm used to compute the path
+ * @return           A shortest path between two cells
+ */
+struct MapGraphPath *mapgraph_shortestPathWith(const struct MapGraph *graph,
+                                               const struct MapCell *start,
+                                               const struct MapCell *end,
+                                               enum MapGraphAlgorithm algorithm);
+
+/**
+ * Creates a path having the given number of cells.
+ *
+ * The cells are not initialized: they are meant to be filled from the last
+ * one to the first one, while following the predecessors found by a search.
+ *
+ * @param numCells  The number of cells in the path
+ * @return          The path
+ */
+struct MapGraphPath *mapgraph_createPath(unsigned int numCells);
+
 /**
  * Prints the given path.
  *
@@ -129,6 +619,34 @@ struct MapGraphPath *mapgraph_shortestPath(const struct MapGraph *graph,
  */
 void mapgraph_printPath(const struct MapGraphPath *path);
 
+/**
+ * Writes the given path to a file, in the same format as mapgraph_printPath.
+ *
+ * @param outputFile  The file to which the path is written
+ * @param path        The path to be written
+ */
+void mapgraph_writePath(FILE *outputFile, const struct MapGraphPath *path);
+
+/**
+ * Returns the number of moves in the given path.
+ *
+ * @param path  The path
+ * @return      The number of moves, or -1 if the path is NULL
+ */
+int mapgraph_pathLength(const struct MapGraphPath *path);
+
+/**
+ * Returns the total cost of the moves in the given path.
+ *
+ * Each move costs the ``cost`` of the tile onto which it moves.
+ *
+ * @param graph  The graph containing the path
+ * @param path   The path
+ * @return       The total cost, or -1 if the path is NULL
+ */
+int mapgraph_pathCost(const struct MapGraph *graph,
+                      const struct MapGraphPath *path);
+
 /**
  * Deletes the given path.
  *
@@ -0,0 +1,495 @@
+#include <stdlib.h>
+#include <assert.h>
+#include "map_hierarchy.h"
+#include "heap.h"
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct MapHierarchyQuery {                 // A search in the abstract graph
+    const struct MapHierarchy *hierarchy;  // The hierarchy
+    unsigned int startNode;                // The node of the starting cell
+    unsigned int endNode;                  // The node of the ending cell
+    unsigned int *distance;                // The distance of each abstract
+                                           // node
+    unsigned int *predecessors;            // The predecessor node of each
+                                           // abstract node
+    bool *closed;                          // True if the abstract node is
+                                           // done
+    Heap heap;                             // The abstract nodes to visit
+};
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Returns the index of the node of the given cell, or MAPGRAPH_NO_NODE.
+ *
+ * @param graph  The graph
+ * @param cell   The cell
+ * @return       The index of the node
+ */
+unsigned int maphierarchy_nodeOf(const struct MapGraph *graph,
+                                 const struct MapCell *cell) {
+    const struct Map *map = graph->map;
+    return graph->nodeIndex[(cell->layer * map->numRows + cell->row)
+                            * map->numColumns + cell->column];
+}
+
+/**
+ * Returns the number of the chunk containing the given cell.
+ *
+ * @param hierarchy  The hierarchy
+ * @param cell       The cell
+ * @return           The number of the chunk
+ */
+unsigned int maphierarchy_chunkOf(const struct MapHierarchy *hierarchy,
+                                  const struct MapCell *cell) {
+    return (cell->row / hierarchy->chunkSize) * hierarchy->numChunkColumns
+           + cell->column / hierarchy->chunkSize;
+}
+
+/**
+ * Returns true if the given node has a neighbor in another chunk.
+ *
+ * @param hierarchy  The hierarchy
+ * @param index      The index of the node
+ * @return           True if the node is an entrance of its chunk
+ */
+bool maphierarchy_isEntrance(const struct MapHierarchy *hierarchy,
+                             unsigned int index) {
+    const struct MapGraph *graph = hierarchy->graph;
+    unsigned int chunk = maphierarchy_chunkOf(hierarchy, &graph->nodes[index].cell);
+    for (unsigned int j = 0; j < mapgraph_numNeighbors(graph, index); ++j) {
+        unsigned int neighbor = mapgraph_getNeighbor(graph, index, j);
+        if (maphierarchy_chunkOf(hierarchy, &graph->nodes[neighbor].cell) != chunk) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Runs a breadth-first search from the given node, without leaving its chunk.
+ *
+ * Once done, the nodes of the chunk reached by the search are stamped with
+ * the current generation of the workspace.
+ *
+ * @param hierarchy  The hierarchy
+ * @param search     The search workspace
+ * @param source     The index of the node from which the search starts
+ */
+void maphierarchy_searchChunk(const struct MapHierarchy *hierarchy,
+                              struct MapGraphSearch *search,
+                              unsigned int source) {
+    const struct MapGraph *graph = hierarchy->graph;
+    unsigned int chunk = maphierarchy_chunkOf(hierarchy, &graph->nodes[source].cell);
+    unsigned int generation = mapgraph_nextGeneration(search);
+    Queue *queue = &search->queue;
+    queue_clear(queue);
+    queue_enqueue(queue, &graph->nodes[source], 0);
+    search->distance[source] = 0;
+    search->predecessors[source] = &graph->nodes[source];
+    search->generations[source] = generation;
+    while (!queue_isEmpty(queue)) {
+        struct QueueContent content = queue_dequeue(queue);
+        unsigned int numNeighbors =
+            mapgraph_numNeighbors(graph, content.cell->index);
+        for (unsigned int i = 0; i < numNeighbors; ++i) {
+            unsigned int index =
+                mapgraph_getNeighbor(graph, content.cell->index, i);
+            if (search->generations[index] != generation &&
+                maphierarchy_chunkOf(hierarchy, &graph->nodes[index].cell) == chunk) {
+                search->generations[index] = generation;
+                search->distance[index] = content.priority + 1;
+                search->predecessors[index] = content.cell;
+                queue_enqueue(queue, &graph->nodes[index], content.priority + 1);
+            }
+        }
+    }
+}
+
+/**
+ * Returns the distance of the given node in the last search of a chunk.
+ *
+ * @param search  The search workspace
+ * @param index   The index of the node
+ * @return        The distance, or MAPHIERARCHY_INFINITY if not reached
+ */
+unsigned int maphierarchy_reached(const struct MapGraphSearch *search,
+                                  unsigned int index) {
+    return search->generations[index] == search->generation ?
+        (unsigned int)search->distance[index] : MAPHIERARCHY_INFINITY;
+}
+
+/**
+ * Computes the entrances of a chunk and the distances between them.
+ *
+ * @param hierarchy  The hierarchy
+ * @param search     A search workspace on the graph of the hierarchy
+ * @param c          The number of the chunk
+ */
+void maphierarchy_buildChunk(struct MapHierarchy *hierarchy,
+                             struct MapGraphSearch *search,
+                             unsigned int c) {
+    const struct MapGraph *graph = hierarchy->graph;
+    const struct Map *map = graph->map;
+    struct MapChunk *chunk = &hierarchy->chunks[c];
+    unsigned int firstRow = (c / hierarchy->numChunkColumns) * hierarchy->chunkSize;
+    unsigned int firstColumn = (c % hierarchy->numChunkColumns) * hierarchy->chunkSize;
+    unsigned int lastRow = firstRow + hierarchy->chunkSize < map->numRows ?
+        firstRow + hierarchy->chunkSize : map->numRows;
+    unsigned int lastColumn = firstColumn + hierarchy->chunkSize < map->numColumns ?
+        firstColumn + hierarchy->chunkSize : map->numColumns;
+    free(chunk->entrances);
+    free(chunk->distances);
+    chunk->entrances = (struct MapCell*)malloc(map->numLayers
+                                               * (lastRow - firstRow)
+                                               * (lastColumn - firstColumn)
+                                               * sizeof(struct MapCell));
+    chunk->numEntrances = 0;
+    for (unsigned int k = 0; k < map->numLayers; ++k) {
+        for (unsigned int i = firstRow; i < lastRow; ++i) {
+            for (unsigned int j = firstColumn; j < lastColumn; ++j) {
+                struct MapCell cell = {i, j, k};
+                unsigned int index = maphierarchy_nodeOf(graph, &cell);
+                if (index != MAPGRAPH_NO_NODE &&
+                    maphierarchy_isEntrance(hierarchy, index)) {
+                    chunk->entrances[chunk->numEntrances] = cell;
+                    ++chunk->numEntrances;
+                }
+            }
+        }
+    }
+    unsigned int n = chunk->numEntrances;
+    chunk->distances = (unsigned int*)malloc(n * n * sizeof(unsigned int));
+    for (unsigned int i = 0; i < n; ++i) {
+        maphierarchy_searchChunk(hierarchy, search,
+                                 maphierarchy_nodeOf(graph, &chunk->entrances[i]));
+        for (unsigned int j = 0; j < n; ++j) {
+            chunk->distances[i * n + j] =
+                maphierarchy_reached(search,
+                                     maphierarchy_nodeOf(graph, &chunk->entrances[j]));
+        }
+    }
+}
+
+/**
+ * Numbers the entrances of all chunks and finds their nodes in the graph.
+ *
+ * @param hierarchy  The hierarchy
+ */
+void maphierarchy_indexEntrances(struct MapHierarchy *hierarchy) {
+    const struct MapGraph *graph = hierarchy->graph;
+    unsigned int numChunks = hierarchy->numChunkRows * hierarchy->numChunkColumns;
+    hierarchy->numEntrances = 0;
+    for (unsigned int c = 0; c < numChunks; ++c) {
+        hierarchy->chunks[c].firstEntrance = hierarchy->numEntrances;
+        hierarchy->numEntrances += hierarchy->chunks[c].numEntrances;
+    }
+    free(hierarchy->entranceNodes);
+    free(hierarchy->entranceChunks);
+    free(hierarchy->entranceOfNode);
+    hierarchy->entranceNodes =
+        (unsigned int*)malloc(hierarchy->numEntrances * sizeof(unsigned int));
+    hierarchy->entranceChunks =
+        (unsigned int*)malloc(hierarchy->numEntrances * sizeof(unsigned int));
+    hierarchy->entranceOfNode =
+        (unsigned int*)malloc(graph->numNodes * sizeof(unsigned int));
+    for (unsigned int i = 0; i < graph->numNodes; ++i) {
+        hierarchy->entranceOfNode[i] = MAPGRAPH_NO_NODE;
+    }
+    for (unsigned int c = 0; c < numChunks; ++c) {
+        const struct MapChunk *chunk = &hierarchy->chunks[c];
+        for (unsigned int i = 0; i < chunk->numEntrances; ++i) {
+            unsigned int e = chunk->firstEntrance + i;
+            unsigned int index = maphierarchy_nodeOf(graph, &chunk->entrances[i]);
+            hierarchy->entranceNodes[e] = index;
+            hierarchy->entranceChunks[e] = c;
+            hierarchy->entranceOfNode[index] = e;
+        }
+    }
+}
+
+/**
+ * Returns the number of the given node in the abstract graph.
+ *
+ * The entrances keep their number, while the starting and the ending cells,
+ * if they are not entrances, come right after the last entrance.
+ *
+ * @param query  The abstract search
+ * @param index  The index of the node
+ * @return       The number of the abstract node
+ */
+unsigned int maphierarchy_abstractNode(const struct MapHierarchyQuery *query,
+                                       unsigned int index) {
+    const struct MapHierarchy *hierarchy = query->hierarchy;
+    if (hierarchy->entranceOfNode[index] != MAPGRAPH_NO_NODE) {
+        return hierarchy->entranceOfNode[index];
+    } else {
+        return index == query->startNode ? hierarchy->numEntrances
+                                         : hierarchy->numEntrances + 1;
+    }
+}
+
+/**
+ * Relaxes an edge of the abstract graph.
+ *
+ * @param query     The abstract search
+ * @param from      The index of the node from which the edge starts
+ * @param to        The index of the node at which the edge ends
+ * @param distance  The distance of the end node through this edge
+ */
+void maphierarchy_relax(struct MapHierarchyQuery *query,
+                        unsigned int from,
+                        unsigned int to,
+                        unsigned int distance) {
+    unsigned int node = maphierarchy_abstractNode(query, to);
+    if (distance < query->distance[node]) {
+        query->distance[node] = distance;
+        query->predecessors[node] = from;
+        const struct MapGraph *graph = query->hierarchy->graph;
+        heap_push(&query->heap, &graph->nodes[to],
+                  distance + mapgraph_estimateDistance(&graph->nodes[to].cell,
+                                                       &graph->nodes[query->endNode].cell));
+    }
+}
+
+/**
+ * Computes the distances from a node to the entrances of its chunk.
+ *
+ * @param hierarchy  The hierarchy
+ * @param search     The search workspace
+ * @param index      The index of the node
+ * @return           The distance to each entrance of the chunk
+ */
+unsigned int *maphierarchy_entranceDistances(const struct MapHierarchy *hierarchy,
+                                             struct MapGraphSearch *search,
+                                             unsigned int index) {
+    const struct MapChunk *chunk =
+        &hierarchy->chunks[maphierarchy_chunkOf(hierarchy,
+                                                &hierarchy->graph->nodes[index].cell)];
+    unsigned int *distances =
+        (unsigned int*)malloc(chunk->numEntrances * sizeof(unsigned int));
+    maphierarchy_searchChunk(hierarchy, search, index);
+    for (unsigned int i = 0; i < chunk->numEntrances; ++i) {
+        distances[i] =
+            maphierarchy_reached(search,
+                                 hierarchy->entranceNodes[chunk->firstEntrance + i]);
+    }
+    return distances;
+}
+
+/**
+ * Refines the abstract path found by a query into a path of the graph.
+ *
+ * Two consecutive abstract nodes in different chunks are neighbors in the
+ * graph. Otherwise, they are joined by a search inside their chunk.
+ *
+ * @param query   The abstract search, which reached the ending cell
+ * @param search  The search workspace
+ * @return        The path from the starting cell to the ending cell
+ */
+struct MapGraphPath *maphierarchy_refine(const struct MapHierarchyQuery *query,
+                                         struct MapGraphSearch *search) {
+    const struct MapHierarchy *hierarchy = query->hierarchy;
+    const struct MapGraph *graph = hierarchy->graph;
+    unsigned int current = query->endNode;
+    unsigned int i =
+        query->distance[maphierarchy_abstractNode(query, current)];
+    struct MapGraphPath *path = mapgraph_createPath(i + 1);
+    path->cells[i] = graph->nodes[current].cell;
+    while (current != query->startNode) {
+        unsigned int previous =
+            query->predecessors[maphierarchy_abstractNode(query, current)];
+        if (maphierarchy_chunkOf(hierarchy, &graph->nodes[previous].cell) ==
+            maphierarchy_chunkOf(hierarchy, &graph->nodes[current].cell)) {
+            maphierarchy_searchChunk(hierarchy, search, previous);
+            for (unsigned int index = current; index != previous;) {
+                index = search->predecessors[index]->index;
+                path->cells[--i] = graph->nodes[index].cell;
+            }
+        } else {
+            path->cells[--i] = graph->nodes[previous].cell;
+        }
+        current = previous;
+    }
+    return path;
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+struct MapHierarchy maphierarchy_create(const struct MapGraph *graph,
+                                        unsigned int chunkSize) {
+    assert(chunkSize > 0);
+    struct MapHierarchy hierarchy;
+    hierarchy.graph = graph;
+    hierarchy.chunkSize = chunkSize;
+    hierarchy.numChunkRows = (graph->map->numRows + chunkSize - 1) / chunkSize;
+    hierarchy.numChunkColumns = (graph->map->numColumns + chunkSize - 1) / chunkSize;
+    unsigned int numChunks = hierarchy.numChunkRows * hierarchy.numChunkColumns;
+    hierarchy.chunks =
+        (struct MapChunk*)calloc(numChunks, sizeof(struct MapChunk));
+    hierarchy.entranceNodes = NULL;
+    hierarchy.entranceChunks = NULL;
+    hierarchy.entranceOfNode = NULL;
+    struct MapGraphSearch search = mapgraph_createSearch(graph);
+    for (unsigned int c = 0; c < numChunks; ++c) {
+        maphierarchy_buildChunk(&hierarchy, &search, c);
+    }
+    mapgraph_deleteSearch(&search);
+    maphierarchy_indexEntrances(&hierarchy);
+    return hierarchy;
+}
+
+void maphierarchy_update(struct MapHierarchy *hierarchy,
+                         const struct MapGraph *graph,
+                         unsigned int row,
+                         unsigned int column) {
+    assert(row    < graph->map->numRows);
+    assert(column < graph->map->numColumns);
+    hierarchy->graph = graph;
+    unsigned int firstRow = (row > 0 ? row - 1 : 0) / hierarchy->chunkSize;
+    unsigned int firstColumn = (column > 0 ? column - 1 : 0) / hierarchy->chunkSize;
+    unsigned int lastRow = (row + 1) / hierarchy->chunkSize;
+    unsigned int lastColumn = (column + 1) / hierarchy->chunkSize;
+    if (lastRow >= hierarchy->numChunkRows) lastRow = hierarchy->numChunkRows - 1;
+    if (lastColumn >= hierarchy->numChunkColumns) {
+        lastColumn = hierarchy->numChunkColumns - 1;
+    }
+    struct MapGraphSearch search = mapgraph_createSearch(graph);
+    for (unsigned int i = firstRow; i <= lastRow; ++i) {
+        for (unsigned int j = firstColumn; j <= lastColumn; ++j) {
+            maphierarchy_buildChunk(hierarchy, &search,
+                                    i * hierarchy->numChunkColumns + j);
+        }
+    }
+    mapgraph_deleteSearch(&search);
+    maphierarchy_indexEntrances(hierarchy);
+}
+
+void maphierarchy_delete(struct MapHierarchy *hierarchy) {
+    unsigned int numChunks = hierarchy->numChunkRows * hierarchy->numChunkColumns;
+    for (unsigned int c = 0; c < numChunks; ++c) {
+        free(hierarchy->chunks[c].entrances);
+        free(hierarchy->chunks[c].distances);
+    }
+    free(hierarchy->chunks);
+    free(hierarchy->entranceNodes);
+    free(hierarchy->entranceChunks);
+    free(hierarchy->entranceOfNode);
+    hierarchy->chunks = NULL;
+    hierarchy->entranceNodes = NULL;
+    hierarchy->entranceChunks = NULL;
+    hierarchy->entranceOfNode = NULL;
+}
+
+struct MapGraphPath *maphierarchy_shortestPath(const struct MapHierarchy *hierarchy,
+                                               struct MapGraphSearch *search,
+                                               const struct MapCell *start,
+                                               const struct MapCell *end) {
+    const struct MapGraph *graph = hierarchy->graph;
+    assert(search->graph == graph);
+    assert(start->row    < graph->map->numRows);
+    assert(start->column < graph->map->numColumns);
+    assert(start->layer  < graph->map->numLayers);
+    assert(end->row      < graph->map->numRows);
+    assert(end->column   < graph->map->numColumns);
+    assert(end->layer    < graph->map->numLayers);
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    struct MapHierarchyQuery query;
+    query.hierarchy = hierarchy;
+    query.startNode = maphierarchy_nodeOf(graph, start);
+    query.endNode = maphierarchy_nodeOf(graph, end);
+    if (query.startNode == query.endNode) {
+        struct MapGraphPath *path = mapgraph_createPath(1);
+        path->cells[0] = *end;
+        return path;
+    }
+    unsigned int startChunk = maphierarchy_chunkOf(hierarchy, start);
+    unsigned int endChunk = maphierarchy_chunkOf(hierarchy, end);
+    unsigned int *endDistances =
+        maphierarchy_entranceDistances(hierarchy, search, query.endNode);
+    unsigned int *startDistances =
+        maphierarchy_entranceDistances(hierarchy, search, query.startNode);
+    unsigned int directDistance = maphierarchy_reached(search, query.endNode);
+    unsigned int numNodes = hierarchy->numEntrances + 2;
+    query.distance = (unsigned int*)malloc(numNodes * sizeof(unsigned int));
+    query.predecessors = (unsigned int*)malloc(numNodes * sizeof(unsigned int));
+    query.closed = (bool*)malloc(numNodes * sizeof(bool));
+    for (unsigned int i = 0; i < numNodes; ++i) {
+        query.distance[i] = MAPHIERARCHY_INFINITY;
+        query.predecessors[i] = MAPGRAPH_NO_NODE;
+        query.closed[i] = false;
+    }
+    query.heap = heap_create(64);
+    query.distance[maphierarchy_abstractNode(&query, query.startNode)] = 0;
+    heap_push(&query.heap, &graph->nodes[query.startNode],
+              mapgraph_estimateDistance(start, end));
+    while (!heap_isEmpty(&query.heap)) {
+        unsigned int index = heap_pop(&query.heap).cell->index;
+        unsigned int node = maphierarchy_abstractNode(&query, index);
+        if (query.closed[node]) continue;
+        if (index == query.endNode) break;
+        query.closed[node] = true;
+        unsigned int distance = query.distance[node];
+        if (index == query.startNode) {
+            const struct MapChunk *chunk = &hierarchy->chunks[startChunk];
+            for (unsigned int i = 0; i < chunk->numEntrances; ++i) {
+                if (startDistances[i] != MAPHIERARCHY_INFINITY) {
+                    maphierarchy_relax(&query, index,
+                                       hierarchy->entranceNodes[chunk->firstEntrance + i],
+                                       startDistances[i]);
+                }
+            }
+            if (directDistance != MAPHIERARCHY_INFINITY) {
+                maphierarchy_relax(&query, index, query.endNode, directDistance);
+            }
+        }
+        if (hierarchy->entranceOfNode[index] != MAPGRAPH_NO_NODE) {
+            unsigned int c = hierarchy->entranceChunks[node];
+            const struct MapChunk *chunk = &hierarchy->chunks[c];
+            unsigned int i = node - chunk->firstEntrance;
+            unsigned int n = chunk->numEntrances;
+            unsigned int predecessor = query.predecessors[node];
+            // Moves inside the chunk are only needed when entering it, since
+            // the predecessor already reached every entrance of its chunk
+            if (predecessor != MAPGRAPH_NO_NODE &&
+                maphierarchy_chunkOf(hierarchy, &graph->nodes[predecessor].cell) != c) {
+                for (unsigned int j = 0; j < n; ++j) {
+                    if (chunk->distances[i * n + j] != MAPHIERARCHY_INFINITY) {
+                        maphierarchy_relax(&query, index,
+                                           hierarchy->entranceNodes[chunk->firstEntrance + j],
+                                           distance + chunk->distances[i * n + j]);
+                    }
+                }
+                if (c == endChunk && endDistances[i] != MAPHIERARCHY_INFINITY) {
+                    maphierarchy_relax(&query, index, query.endNode,
+                                       distance + endDistances[i]);
+                }
+            }
+            for (unsigned int j = 0; j < mapgraph_numNeighbors(graph, index); ++j) {
+                unsigned int neighbor = mapgraph_getNeighbor(graph, index, j);
+                if (maphierarchy_chunkOf(hierarchy, &graph->nodes[neighbor].cell) != c) {
+                    maphierarchy_relax(&query, index, neighbor, distance + 1);
+                }
+            }
+        }
+    }
+    struct MapGraphPath *path = NULL;
+    if (query.distance[maphierarchy_abstractNode(&query, query.endNode)]
+        != MAPHIERARCHY_INFINITY) {
+        path = maphierarchy_refine(&query, search);
+    }
+    heap_delete(&query.heap);
+    free(query.distance);
+    free(query.predecessors);
+    free(query.closed);
+    free(startDistances);
+    free(endDistances);
+    return path;
+}
@@ -0,0 +1,119 @@
+/**
+ * Module map_hierarchy
+ *
+ * This module computes shortest paths on large maps by hierarchical search
+ * (a variant of HPA*).
+ *
+ * The map is split into square chunks of a fixed number of rows and columns,
+ * each chunk containing every layer. A node of the graph is an entrance of
+ * its chunk if it has a neighbor in another chunk. For each chunk, the
+ * distances between its entrances, moving only inside the chunk, are
+ * computed once and stored in a table.
+ *
+ * A query first searches, with A*, the abstract graph whose nodes are the
+ * entrances, the starting cell and the ending cell, and whose edges are the
+ * moves between chunks and the distances inside each chunk. The abstract path
+ * is then refined into a path of the graph by a breadth-first search
+ * restricted to each traversed chunk. Since every move between two chunks is
+ * kept in the abstract graph, the returned paths are as short as those
+ * returned by ``mapgraph_shortestPath``.
+ *
+ * The chunks are stored by their cells rather than by the indices of the
+ * nodes, so that after a local edit of the map, only the chunks around the
+ * edited cell are preprocessed again (see ``maphierarchy_update``).
+ */
+#ifndef MAP_HIERARCHY_H
+#define MAP_HIERARCHY_H
+
+#include "map_graph.h"
+
+#define MAPHIERARCHY_CHUNK_SIZE 16               // Default size of a chunk
+#define MAPHIERARCHY_INFINITY ((unsigned int)-1) // Distance without path
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct MapChunk {               // A chunk of a map
+    struct MapCell *entrances;  // The entrances of the chunk
+    unsigned int numEntrances;  // The number of entrances
+    unsigned int *distances;    // The distance between each pair of
+                                // entrances, inside the chunk
+    unsigned int firstEntrance; // The number of the first entrance among
+                                // all entrances of the hierarchy
+};
+
+struct MapHierarchy {              // A hierarchy of chunks over a map graph
+    const struct MapGraph *graph;  // The graph
+    unsigned int chunkSize;        // The number of rows and columns of a chunk
+    unsigned int numChunkRows;     // The number of rows of chunks
+    unsigned int numChunkColumns;  // The number of columns of chunks
+    struct MapChunk *chunks;       // The chunks, row by row
+    unsigned int numEntrances;     // The number of entrances of all chunks
+    unsigned int *entranceNodes;   // The node index of each entrance
+    unsigned int *entranceChunks;  // The chunk of each entrance
+    unsigned int *entranceOfNode;  // The entrance number of each node, or
+                                   // MAPGRAPH_NO_NODE
+};
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Creates the hierarchy of the given graph.
+ *
+ * Every chunk is preprocessed, which requires one breadth-first search inside
+ * the chunk for each of its entrances.
+ *
+ * @param graph      The graph
+ * @param chunkSize  The number of rows and columns of a chunk
+ * @return           The hierarchy
+ */
+struct MapHierarchy maphierarchy_create(const struct MapGraph *graph,
+                                        unsigned int chunkSize);
+
+/**
+ * Updates the hierarchy after the column of a single cell was edited.
+ *
+ * The graph must have been rebuilt from the edited map. Only the chunks
+ * containing the edited column or one of its neighboring columns are
+ * preprocessed again, the others being reused as is.
+ *
+ * @param hierarchy  The hierarchy to update
+ * @param graph      The graph of the edited map
+ * @param row        The row of the edited cell
+ * @param column     The column of the edited cell
+ */
+void maphierarchy_update(struct MapHierarchy *hierarchy,
+                         const struct MapGraph *graph,
+                         unsigned int row,
+                         unsigned int column);
+
+/**
+ * Deletes the given hierarchy.
+ *
+ * @param hierarchy  The hierarchy to delete
+ */
+void maphierarchy_delete(struct MapHierarchy *hierarchy);
+
+/**
+ * Returns a shortest path between two cells, using the given hierarchy.
+ *
+ * The hierarchy is only read, so that many threads can search the same
+ * hierarchy as long as each one owns its workspace.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param hierarchy  The hierarchy
+ * @param search     A search workspace on the graph of the hierarchy
+ * @param start      The starting cell
+ * @param end        The ending cell
+ * @return           A shortest path between two cells
+ */
+struct MapGraphPath *maphierarchy_shortestPath(const struct MapHierarchy *hierarchy,
+                                               struct MapGraphSearch *search,
+                                               const struct MapCell *start,
+                                               const struct MapCell *end);
+
+#endif
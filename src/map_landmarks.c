@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "map_landmarks.h"
+#include "heap.h"
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Mixes a value into a checksum (FNV-1a).
+ *
+ * @param checksum  The checksum
+ * @param value     The value
+ * @return          The new checksum
+ */
+uint32_t maplandmarks_mix(uint32_t checksum, uint32_t value) {
+    for (unsigned int i = 0; i < 4; ++i) {
+        checksum = (checksum ^ ((value >> (8 * i)) & 0xff)) * 16777619u;
+    }
+    return checksum;
+}
+
+/**
+ * Writes unsigned 32-bit integers in little-endian order.
+ *
+ * @param outputFile   The file to which the integers are written
+ * @param values       The integers
+ * @param numValues    The number of integers
+ * @return             True if all the integers could be written
+ */
+bool maplandmarks_writeIntegers(FILE *outputFile,
+                                const uint32_t *values,
+                                size_t numValues) {
+    unsigned char *bytes = (unsigned char*)malloc(4 * numValues + 1);
+    for (size_t i = 0; i < numValues; ++i) {
+        bytes[4 * i]     = values[i] & 0xff;
+        bytes[4 * i + 1] = (values[i] >> 8) & 0xff;
+        bytes[4 * i + 2] = (values[i] >> 16) & 0xff;
+        bytes[4 * i + 3] = (values[i] >> 24) & 0xff;
+    }
+    bool complete = fwrite(bytes, 4, numValues, outputFile) == numValues;
+    free(bytes);
+    return complete;
+}
+
+/**
+ * Reads unsigned 32-bit integers written in little-endian order.
+ *
+ * @param inputFile  The file from which the integers are read
+ * @param values     The integers
+ * @param numValues  The number of integers
+ * @return           True if all the integers could be read
+ */
+bool maplandmarks_readIntegers(FILE *inputFile,
+                               uint32_t *values,
+                               size_t numValues) {
+    unsigned char *bytes = (unsigned char*)malloc(4 * numValues + 1);
+    bool complete = fread(bytes, 4, numValues, inputFile) == numValues;
+    for (size_t i = 0; complete && i < numValues; ++i) {
+        values[i] = (uint32_t)bytes[4 * i] |
+                    ((uint32_t)bytes[4 * i + 1] << 8) |
+                    ((uint32_t)bytes[4 * i + 2] << 16) |
+                    ((uint32_t)bytes[4 * i + 3] << 24);
+    }
+    free(bytes);
+    return complete;
+}
+
+/**
+ * Returns the index of the node of the given cell, or MAPGRAPH_NO_NODE.
+ *
+ * @param graph  The graph
+ * @param cell   The cell
+ * @return       The index of the node
+ */
+unsigned int maplandmarks_nodeOf(const struct MapGraph *graph,
+                                 const struct MapCell *cell) {
+    const struct Map *map = graph->map;
+    return graph->nodeIndex[(cell->layer * map->numRows + cell->row)
+                            * map->numColumns + cell->column];
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+struct MapLandmarks maplandmarks_create(const struct MapGraph *graph,
+                                        unsigned int numLandmarks) {
+    struct MapLandmarks landmarks;
+    unsigned int numNodes = graph->numNodes;
+    if (numLandmarks > MAPLANDMARKS_MAX) numLandmarks = MAPLANDMARKS_MAX;
+    if (numLandmarks > numNodes) numLandmarks = numNodes;
+    landmarks.graph = graph;
+    landmarks.checksum = maplandmarks_checksum(graph);
+    landmarks.numLandmarks = numLandmarks;
+    landmarks.landmarkNodes =
+        (unsigned int*)malloc(numLandmarks * sizeof(unsigned int));
+    landmarks.distances =
+        (uint32_t*)malloc((size_t)numNodes * numLandmarks
+                          * sizeof(uint32_t));
+    if (numLandmarks == 0) return landmarks;
+    uint32_t *closestLandmark = (uint32_t*)malloc(numNodes * sizeof(uint32_t));
+    struct MapGraphSearch search = mapgraph_createSearch(graph);
+    mapgraph_searchFrom(&search, &graph->nodes[0].cell);
+    unsigned int candidate = 0;
+    for (unsigned int i = 0; i < numNodes; ++i) {
+        closestLandmark[i] = MAPLANDMARKS_UNREACHABLE;
+        if (search.generations[i] == search.generation &&
+            search.distance[i] > search.distance[candidate]) {
+            candidate = i;
+        }
+    }
+    for (unsigned int l = 0; l < numLandmarks; ++l) {
+        landmarks.landmarkNodes[l] = candidate;
+        mapgraph_searchFrom(&search, &graph->nodes[candidate].cell);
+        closestLandmark[candidate] = 0;
+        unsigned int next = candidate;
+        for (unsigned int i = 0; i < numNodes; ++i) {
+            uint32_t distance = search.generations[i] == search.generation ?
+                (uint32_t)search.distance[i] : MAPLANDMARKS_UNREACHABLE;
+            landmarks.distances[(size_t)i * numLandmarks + l] = distance;
+            if (distance < closestLandmark[i]) closestLandmark[i] = distance;
+            if (closestLandmark[i] > closestLandmark[next]) next = i;
+        }
+        candidate = next;
+    }
+    mapgraph_deleteSearch(&search);
+    free(closestLandmark);
+    return landmarks;
+}
+
+void maplandmarks_delete(struct MapLandmarks *landmarks) {
+    free(landmarks->landmarkNodes);
+    free(landmarks->distances);
+    landmarks->landmarkNodes = NULL;
+    landmarks->distances = NULL;
+    landmarks->numLandmarks = 0;
+}
+
+unsigned int maplandmarks_estimate(const struct MapLandmarks *landmarks,
+                                   unsigned int node,
+                                   unsigned int endNode) {
+    const struct MapGraph *graph = landmarks->graph;
+    unsigned int estimate =
+        mapgraph_estimateDistance(&graph->nodes[node].cell,
+                                  &graph->nodes[endNode].cell);
+    const uint32_t *fromNode =
+        &landmarks->distances[(size_t)node * landmarks->numLandmarks];
+    const uint32_t *fromEnd =
+        &landmarks->distances[(size_t)endNode * landmarks->numLandmarks];
+    for (unsigned int l = 0; l < landmarks->numLandmarks; ++l) {
+        if (fromNode[l] == MAPLANDMARKS_UNREACHABLE ||
+            fromEnd[l] == MAPLANDMARKS_UNREACHABLE) {
+            continue;
+        }
+        unsigned int bound = fromNode[l] > fromEnd[l] ?
+            fromNode[l] - fromEnd[l] : fromEnd[l] - fromNode[l];
+        if (bound > estimate) estimate = bound;
+    }
+    return estimate;
+}
+
+struct MapGraphPath *maplandmarks_shortestPath(const struct MapLandmarks *landmarks,
+                                               struct MapGraphSearch *search,
+                                               const struct MapCell *start,
+                                               const struct MapCell *end) {
+    const struct MapGraph *graph = search->graph;
+    assert(landmarks->graph == graph);
+    assert(mapgraph_hasCell(graph, start));
+    assert(mapgraph_hasCell(graph, end));
+    if (!mapgraph_areConnected(graph, start, end)) return NULL;
+    unsigned int generation = mapgraph_nextGeneration(search);
+    unsigned int startIndex = maplandmarks_nodeOf(graph, start);
+    unsigned int endIndex = maplandmarks_nodeOf(graph, end);
+    struct MapCellNode *startNode = &graph->nodes[startIndex];
+    Heap heap = heap_create(64);
+    heap_push(&heap, startNode,
+              maplandmarks_estimate(landmarks, startIndex, endIndex));
+    search->generations[startIndex] = generation;
+    search->distance[startIndex] = 0;
+    search->predecessors[startIndex] = startNode;
+    while (!heap_isEmpty(&heap)) {
+        struct QueueContent content = heap_pop(&heap);
+        struct MapCellNode *node = content.cell;
+        if (content.priority > search->distance[node->index] +
+            maplandmarks_estimate(landmarks, node->index, endIndex)) {
+            continue;
+        }
+        if (node->index == endIndex) break;
+        unsigned int numNeighbors = mapgraph_numNeighbors(graph, node->index);
+        for (unsigned int i = 0; i < numNeighbors; ++i) {
+            unsigned int index = mapgraph_getNeighbor(graph, node->index, i);
+            int neighborDistance = search->distance[node->index] + 1;
+            if (search->generations[index] != generation ||
+                neighborDistance < search->distance[index]) {
+                search->generations[index] = generation;
+                search->distance[index] = neighborDistance;
+                search->predecessors[index] = node;
+                heap_push(&heap, &graph->nodes[index],
+                          neighborDistance +
+                          maplandmarks_estimate(landmarks, index, endIndex));
+            }
+        }
+    }
+    heap_delete(&heap);
+    return mapgraph_pathFromSource(search, end);
+}
+
+uint32_t maplandmarks_checksum(const struct MapGraph *graph) {
+    uint32_t checksum = maplandmarks_mix(2166136261u, graph->numNodes);
+    for (unsigned int i = 0; i < graph->numNodes; ++i) {
+        const struct MapCell *cell = &graph->nodes[i].cell;
+        unsigned int numNeighbors = mapgraph_numNeighbors(graph, i);
+        checksum = maplandmarks_mix(checksum, cell->layer);
+        checksum = maplandmarks_mix(checksum, cell->row);
+        checksum = maplandmarks_mix(checksum, cell->column);
+        checksum = maplandmarks_mix(checksum, numNeighbors);
+        for (unsigned int j = 0; j < numNeighbors; ++j) {
+            checksum = maplandmarks_mix(checksum,
+                                        mapgraph_getNeighbor(graph, i, j));
+        }
+    }
+    return checksum;
+}
+
+bool maplandmarks_save(const struct MapLandmarks *landmarks,
+                       const char *filename) {
+    FILE *outputFile = fopen(filename, "wb");
+    if (outputFile == NULL) return false;
+    unsigned int numNodes = landmarks->graph->numNodes;
+    uint32_t header[3] = {landmarks->checksum, numNodes,
+                          landmarks->numLandmarks};
+    bool complete =
+        fwrite("LMKS", 1, 4, outputFile) == 4 &&
+        maplandmarks_writeIntegers(outputFile, header, 3) &&
+        maplandmarks_writeIntegers(outputFile, landmarks->landmarkNodes,
+                                   landmarks->numLandmarks) &&
+        maplandmarks_writeIntegers(outputFile, landmarks->distances,
+                                   (size_t)numNodes * landmarks->numLandmarks);
+    complete = fclose(outputFile) == 0 && complete;
+    if (!complete) remove(filename);
+    return complete;
+}
+
+bool maplandmarks_load(struct MapLandmarks *landmarks,
+                       const struct MapGraph *graph,
+                       const char *filename) {
+    FILE *inputFile = fopen(filename, "rb");
+    if (inputFile == NULL) return false;
+    char magic[4];
+    uint32_t header[3];
+    bool valid = fread(magic, 1, 4, inputFile) == 4 &&
+                 memcmp(magic, "LMKS", 4) == 0 &&
+                 maplandmarks_readIntegers(inputFile, header, 3) &&
+                 header[1] == graph->numNodes &&
+                 header[2] <= MAPLANDMARKS_MAX &&
+                 header[2] <= graph->numNodes &&
+                 (header[2] == 0 ||
+                  header[1] <= SIZE_MAX / sizeof(uint32_t) / header[2]) &&
+                 header[0] == maplandmarks_checksum(graph);
+    uint32_t checksum = 0;
+    uint32_t numNodes = 0;
+    uint32_t numLandmarks = 0;
+    unsigned int *landmarkNodes = NULL;
+    uint32_t *distances = NULL;
+    if (valid) {
+        checksum = header[0];
+        numNodes = header[1];
+        numLandmarks = header[2];
+        landmarkNodes =
+            (unsigned int*)malloc(numLandmarks * sizeof(unsigned int));
+        distances = (uint32_t*)malloc((size_t)numNodes * numLandmarks
+                                      * sizeof(uint32_t));
+        valid = maplandmarks_readIntegers(inputFile, landmarkNodes,
+                                          numLandmarks) &&
+                maplandmarks_readIntegers(inputFile, distances,
+                                          (size_t)numNodes * numLandmarks);
+        for (unsigned int l = 0; valid && l < numLandmarks; ++l) {
+            valid = landmarkNodes[l] < numNodes;
+        }
+    }
+    fclose(inputFile);
+    if (valid) {
+        landmarks->graph = graph;
+        landmarks->checksum = checksum;
+        landmarks->numLandmarks = numLandmarks;
+        landmarks->landmarkNodes = landmarkNodes;
+        landmarks->distances = distances;
+    } else {
+        free(landmarkNodes);
+        free(distances);
+    }
+    return valid;
+}
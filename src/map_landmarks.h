@@ -0,0 +1,162 @@
+/**
+ * Module map_landmarks
+ *
+ * This module speeds up A* on static maps by landmarks (the ALT algorithm,
+ * for A*, Landmarks and Triangle inequality).
+ *
+ * A few nodes of the graph are chosen as landmarks, and the distance from
+ * each landmark to every node is computed once by a breadth-first search.
+ * Since the moves of a map graph can be done in both directions, the
+ * triangle inequality gives, for any landmark L, the lower bound
+ * ``|d(L, end) - d(L, node)|`` on the distance between a node and the ending
+ * cell. The largest of these bounds is a much better estimate than the
+ * distance between the cells on the map, as soon as walls or holes force
+ * detours, so that A* visits far fewer nodes.
+ *
+ * The landmarks are chosen one after the other as far as possible from the
+ * previous ones: the first one is the node farthest from an arbitrary node,
+ * and the next one is the node whose distance to its closest landmark is the
+ * largest, a node unreachable from every landmark being the farthest of all.
+ * Hence, every connected component receives landmarks.
+ *
+ * The distances are stored node by node, the distances of a node to all the
+ * landmarks being contiguous. The tables can be saved in a file next to the
+ * map and loaded again, so that they are computed once per map. The file
+ * starts with the four bytes ``LMKS``, then contains the checksum of the
+ * graph, the number of nodes, the number of landmarks, the node index of each
+ * landmark and finally the distances, all as unsigned 32-bit integers in
+ * little-endian order. Tables whose checksum differs from the one of the
+ * graph are rejected when they are loaded.
+ */
+#ifndef MAP_LANDMARKS_H
+#define MAP_LANDMARKS_H
+
+#include <stdint.h>
+#include "map_graph.h"
+
+#define MAPLANDMARKS_COUNT 8                      // Default number of landmarks
+#define MAPLANDMARKS_MAX 64                       // Largest number of landmarks
+#define MAPLANDMARKS_UNREACHABLE ((uint32_t)-1)   // Distance without path
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct MapLandmarks {             // Landmarks of a map graph
+    const struct MapGraph *graph; // The graph
+    uint32_t checksum;            // The checksum of the graph
+    unsigned int numLandmarks;    // The number of landmarks
+    unsigned int *landmarkNodes;  // The node index of each landmark
+    uint32_t *distances;          // The distance from each node to each
+                                  // landmark, node by node
+};
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Chooses landmarks in the given graph and computes their distances.
+ *
+ * One breadth-first search is done for each landmark. At most
+ * ``MAPLANDMARKS_MAX`` landmarks are chosen, and if the graph has fewer nodes
+ * than the requested number of landmarks, every node is a landmark.
+ *
+ * @param graph         The graph
+ * @param numLandmarks  The number of landmarks
+ * @return              The landmarks
+ */
+struct MapLandmarks maplandmarks_create(const struct MapGraph *graph,
+                                        unsigned int numLandmarks);
+
+/**
+ * Deletes the given landmarks.
+ *
+ * @param landmarks  The landmarks to delete
+ */
+void maplandmarks_delete(struct MapLandmarks *landmarks);
+
+/**
+ * Returns a lower bound on the number of moves between two nodes.
+ *
+ * The bound is the largest of the triangle inequality bounds given by the
+ * landmarks and of ``mapgraph_estimateDistance``.
+ *
+ * @param landmarks  The landmarks
+ * @param node       The index of the first node
+ * @param endNode    The index of the second node
+ * @return           A lower bound on the number of moves between the nodes
+ */
+unsigned int maplandmarks_estimate(const struct MapLandmarks *landmarks,
+                                   unsigned int node,
+                                   unsigned int endNode);
+
+/**
+ * Returns a shortest path between two cells, using A* guided by the given
+ * landmarks.
+ *
+ * The estimate of the remaining distance is ``maplandmarks_estimate``, which
+ * is never smaller than the estimate of ``mapgraph_shortestPathAStar``, so
+ * that fewer nodes are explored for the same result. The distances and the
+ * predecessors are kept in the workspace, and since the estimate is
+ * consistent, a node taken from the heap whose priority is larger than its
+ * current distance plus its estimate is an outdated entry and is skipped.
+ *
+ * The landmarks are only read, so that many threads can search with the same
+ * landmarks as long as each one owns its workspace.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param landmarks  The landmarks
+ * @param search     A search workspace on the graph of the landmarks
+ * @param start      The starting cell
+ * @param end        The ending cell
+ * @return           A shortest path between two cells
+ */
+struct MapGraphPath *maplandmarks_shortestPath(const struct MapLandmarks *landmarks,
+                                               struct MapGraphSearch *search,
+                                               const struct MapCell *start,
+                                               const struct MapCell *end);
+
+/**
+ * Returns the checksum of the given graph.
+ *
+ * The checksum depends on the cells of the nodes and on their neighbors, so
+ * that two graphs having the same checksum almost surely have the same
+ * shortest paths.
+ *
+ * @param graph  The graph
+ * @return       The checksum of the graph
+ */
+uint32_t maplandmarks_checksum(const struct MapGraph *graph);
+
+/**
+ * Saves the landmarks in a file.
+ *
+ * If the file cannot be written completely, it is removed, so that a
+ * truncated table is never left next to the map.
+ *
+ * @param landmarks  The landmarks
+ * @param filename   The name of the file
+ * @return           True if the file could be written
+ */
+bool maplandmarks_save(const struct MapLandmarks *landmarks,
+                       const char *filename);
+
+/**
+ * Loads the landmarks of the given graph from a file.
+ *
+ * If the file cannot be read, is not a file of landmarks, has more than
+ * ``MAPLANDMARKS_MAX`` landmarks, or was computed for a different graph,
+ * then false is returned and the landmarks are left unchanged.
+ *
+ * @param landmarks  The loaded landmarks
+ * @param graph      The graph
+ * @param filename   The name of the file
+ * @return           True if the landmarks were loaded
+ */
+bool maplandmarks_load(struct MapLandmarks *landmarks,
+                       const struct MapGraph *graph,
+                       const char *filename);
+
+#endif
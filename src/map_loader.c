@@ -38,6 +38,10 @@ void map_loadTiles(struct Map *map, const json_t *jsonTiles) {
         const char *name = json_string_value(json_object_get(jsonTile, "id"));
         const char *filename = json_string_value(json_object_get(jsonTile, "filename"));
         struct Tile *tile = map_addTile(map, name, filename);
+        json_t *jsonCost = json_object_get(jsonTile, "cost");
+        if (jsonCost != NULL) {
+            tile->cost = (unsigned int)json_integer_value(jsonCost);
+        }
         map_loadDirections(tile, jsonTile);
     }
 }
@@ -53,13 +57,14 @@ void map_loadLayers(struct Map *map, const json_t *jsonLayers, int layerOffset)
     json_t *jsonLayer;
     json_array_foreach(jsonLayers, i, jsonLayer) {
         int yoffset = layerOffset * i;
-        struct Layer *layer = map_addLayer(map, 0, yoffset);
+        map_addLayer(map, 0, yoffset);
         json_t *data = json_object_get(jsonLayer, "data");
         unsigned int j;
         json_t *dataTile;
         json_array_foreach(data, j, dataTile) {
             unsigned int tileID = (unsigned int)json_integer_value(dataTile);
-            layer->tiles[j / map->numColumns][j % map->numColumns] = tileID;
+            map_setTile(map, map->numLayers - 1,
+                        j / map->numColumns, j % map->numColumns, tileID);
         }
     }
 }
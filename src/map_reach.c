@@ -0,0 +1,264 @@
+#include <assert.h>
+#include "map_reach.h"
+#include "map_search.h"
+
+#define NO_TARGET ((unsigned int)-1) // Marks a cell that is not a target
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Returns the position of a cell in the arrays of a workspace.
+ *
+ * @param map   The map
+ * @param cell  The cell
+ * @return      The position of the cell
+ */
+unsigned int mapreach_cellIndex(const struct Map *map,
+                                const struct MapCell *cell) {
+    return (cell->layer * map->numRows + cell->row) * map->numColumns
+           + cell->column;
+}
+
+/**
+ * Returns the allowed moves of a cell that can be visited.
+ *
+ * @param map   The map
+ * @param cell  The cell
+ * @return      The bit of each direction leading to a neighbor
+ */
+uint32_t mapreach_cellMoves(const struct Map *map, const struct MapCell *cell) {
+    const struct Tile *tile =
+        &map->tiles[map_getTile(map, cell->layer, cell->row, cell->column)];
+    uint32_t moves = 0;
+    for (uint32_t mask = tile->directionMask; mask != 0; mask &= mask - 1) {
+        unsigned int bit = map_firstDirection(mask);
+        struct Direction direction = map_bitDirection(bit);
+        struct MapCell neighbor = {
+            cell->row + direction.deltaRow,
+            cell->column + direction.deltaColumn,
+            cell->layer + direction.deltaLayer
+        };
+        if (!mapsearch_isFree(map, &neighbor)) continue;
+        const struct Tile *neighborTile = &map->tiles[
+            map_getTile(map, neighbor.layer, neighbor.row, neighbor.column)];
+        if ((neighborTile->directionMask
+             & ((uint32_t)1 << (MAP_NUM_DIRECTIONS - 1 - bit))) != 0) {
+            moves |= (uint32_t)1 << bit;
+        }
+    }
+    return moves;
+}
+
+/**
+ * Records the distances of the targets of a cell that has just been reached.
+ *
+ * @param reach          The workspace
+ * @param index          The position of the reached cell
+ * @param bits           The starting cells that have just reached the cell
+ * @param distance       The number of moves from these starting cells
+ * @param targetSources  The starting cell of each target
+ * @param nextTarget     The next target on the same cell, for each target
+ * @param distances      The distance of each target
+ * @return               The number of recorded distances
+ */
+unsigned int mapreach_recordTargets(const struct MapReach *reach,
+                                    unsigned int index,
+                                    uint64_t bits,
+                                    int distance,
+                                    const unsigned int *targetSources,
+                                    const unsigned int *nextTarget,
+                                    int *distances) {
+    unsigned int numRecorded = 0;
+    for (unsigned int t = reach->targetIndex[index]; t != NO_TARGET;
+         t = nextTarget[t]) {
+        if ((bits >> targetSources[t] & 1) != 0) {
+            distances[t] = distance;
+            ++numRecorded;
+        }
+    }
+    return numRecorded;
+}
+
+/**
+ * Allocates the state of a sweep workspace, without its moves.
+ *
+ * @param map  The map
+ * @return     The workspace
+ */
+struct MapReach mapreach_allocate(const struct Map *map) {
+    struct MapReach reach;
+    reach.map = map;
+    reach.numCells = map->numLayers * map->numRows * map->numColumns;
+    unsigned int size = reach.numCells > 0 ? reach.numCells : 1;
+    reach.reached = (uint64_t*)calloc(size, sizeof(uint64_t));
+    reach.visit = (uint64_t*)calloc(size, sizeof(uint64_t));
+    reach.visitNext = (uint64_t*)calloc(size, sizeof(uint64_t));
+    reach.frontier = (unsigned int*)malloc(size * sizeof(unsigned int));
+    reach.nextFrontier = (unsigned int*)malloc(size * sizeof(unsigned int));
+    reach.targetIndex = (unsigned int*)malloc(size * sizeof(unsigned int));
+    reach.touched = (unsigned int*)malloc(size * sizeof(unsigned int));
+    reach.numTouched = 0;
+    for (unsigned int i = 0; i < reach.numCells; ++i) {
+        reach.targetIndex[i] = NO_TARGET;
+    }
+    return reach;
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+struct MapReach mapreach_create(const struct Map *map) {
+    struct MapReach reach = mapreach_allocate(map);
+    unsigned int size = reach.numCells > 0 ? reach.numCells : 1;
+    reach.moves = (uint32_t*)malloc(size * sizeof(uint32_t));
+    reach.ownsMoves = true;
+    for (unsigned int i = 0; i < reach.numCells; ++i) {
+        struct MapCell cell = {
+            (i / map->numColumns) % map->numRows,
+            i % map->numColumns,
+            i / (map->numColumns * map->numRows)
+        };
+        reach.moves[i] = mapsearch_isFree(map, &cell) ?
+            mapreach_cellMoves(map, &cell) : 0;
+    }
+    return reach;
+}
+
+struct MapReach mapreach_createShared(const struct MapReach *reach) {
+    struct MapReach shared = mapreach_allocate(reach->map);
+    shared.moves = reach->moves;
+    shared.ownsMoves = false;
+    return shared;
+}
+
+void mapreach_delete(struct MapReach *reach) {
+    if (reach->ownsMoves) free(reach->moves);
+    free(reach->reached);
+    free(reach->visit);
+    free(reach->visitNext);
+    free(reach->frontier);
+    free(reach->nextFrontier);
+    free(reach->targetIndex);
+    free(reach->touched);
+    reach->moves = NULL;
+    reach->reached = NULL;
+    reach->visit = NULL;
+    reach->visitNext = NULL;
+    reach->frontier = NULL;
+    reach->nextFrontier = NULL;
+    reach->targetIndex = NULL;
+    reach->touched = NULL;
+}
+
+void mapreach_search(struct MapReach *reach,
+                     const struct MapCell *sources,
+                     unsigned int numSources,
+                     const struct MapCell *targets,
+                     const unsigned int *targetSources,
+                     unsigned int numTargets,
+                     int *distances) {
+    assert(numSources <= MAPREACH_MAX_SOURCES);
+    const struct Map *map = reach->map;
+    for (unsigned int i = 0; i < reach->numTouched; ++i) {
+        reach->reached[reach->touched[i]] = 0;
+    }
+    reach->numTouched = 0;
+    unsigned int *nextTarget =
+        (unsigned int*)malloc((numTargets > 0 ? numTargets : 1)
+                              * sizeof(unsigned int));
+    unsigned int numPending = 0;
+    for (unsigned int t = 0; t < numTargets; ++t) {
+        assert(targetSources[t] < numSources);
+        distances[t] = -1;
+        if (!mapsearch_isFree(map, &sources[targetSources[t]]) ||
+            !mapsearch_isFree(map, &targets[t])) {
+            continue;
+        }
+        unsigned int index = mapreach_cellIndex(map, &targets[t]);
+        nextTarget[t] = reach->targetIndex[index];
+        reach->targetIndex[index] = t;
+        ++numPending;
+    }
+    unsigned int numFrontier = 0;
+    for (unsigned int s = 0; s < numSources; ++s) {
+        if (!mapsearch_isFree(map, &sources[s])) continue;
+        unsigned int index = mapreach_cellIndex(map, &sources[s]);
+        if (reach->visit[index] == 0) reach->frontier[numFrontier++] = index;
+        if (reach->reached[index] == 0) {
+            reach->touched[reach->numTouched++] = index;
+        }
+        reach->visit[index] |= (uint64_t)1 << s;
+        reach->reached[index] |= (uint64_t)1 << s;
+    }
+    if (numTargets == 0) numPending = (unsigned int)-1;
+    int distance = 0;
+    while (numFrontier > 0) {
+        for (unsigned int i = 0; i < numFrontier && numTargets > 0; ++i) {
+            unsigned int index = reach->frontier[i];
+            numPending -= mapreach_recordTargets(reach, index,
+                                                 reach->visit[index], distance,
+                                                 targetSources, nextTarget,
+                                                 distances);
+        }
+        if (numPending == 0) break;
+        unsigned int numNext = 0;
+        for (unsigned int i = 0; i < numFrontier; ++i) {
+            unsigned int index = reach->frontier[i];
+            uint64_t bits = reach->visit[index];
+            reach->visit[index] = 0;
+            for (uint32_t mask = reach->moves[index]; mask != 0;
+                 mask &= mask - 1) {
+                unsigned int neighbor =
+                    index + map->directionOffsets[map_firstDirection(mask)];
+                uint64_t newBits = bits & ~reach->reached[neighbor];
+                if (newBits == 0) continue;
+                if (reach->visitNext[neighbor] == 0) {
+                    reach->nextFrontier[numNext++] = neighbor;
+                }
+                if (reach->reached[neighbor] == 0) {
+                    reach->touched[reach->numTouched++] = neighbor;
+                }
+                reach->visitNext[neighbor] |= newBits;
+                reach->reached[neighbor] |= newBits;
+            }
+        }
+        uint64_t *visit = reach->visit;
+        reach->visit = reach->visitNext;
+        reach->visitNext = visit;
+        unsigned int *frontier = reach->frontier;
+        reach->frontier = reach->nextFrontier;
+        reach->nextFrontier = frontier;
+        numFrontier = numNext;
+        ++distance;
+    }
+    for (unsigned int i = 0; i < numFrontier; ++i) {
+        reach->visit[reach->frontier[i]] = 0;
+    }
+    for (unsigned int t = 0; t < numTargets; ++t) {
+        if (mapsearch_isFree(map, &targets[t])) {
+            reach->targetIndex[mapreach_cellIndex(map, &targets[t])] =
+                NO_TARGET;
+        }
+    }
+    free(nextTarget);
+}
+
+uint64_t mapreach_sources(const struct MapReach *reach,
+                          const struct MapCell *cell) {
+    if (cell->layer  >= reach->map->numLayers ||
+        cell->row    >= reach->map->numRows ||
+        cell->column >= reach->map->numColumns) {
+        return 0;
+    }
+    return reach->reached[mapreach_cellIndex(reach->map, cell)];
+}
+
+bool mapreach_isReachable(const struct MapReach *reach,
+                          unsigned int source,
+                          const struct MapCell *cell) {
+    assert(source < MAPREACH_MAX_SOURCES);
+    return (mapreach_sources(reach, cell) >> source & 1) != 0;
+}
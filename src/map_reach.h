@@ -0,0 +1,142 @@
+/**
+ * Module map_reach
+ *
+ * This module answers reachability and distance queries from up to 64
+ * starting cells at once, directly on the layers of a map.
+ *
+ * Each cell of the map is given a 64-bit word, whose bit ``s`` tells whether
+ * the starting cell ``s`` reaches the cell. The breadth-first searches from
+ * all the starting cells then advance together, level by level: a cell of
+ * the frontier passes the bits it has just received to each of its neighbors
+ * with a single AND and OR, so that one sweep of the map does the work of up
+ * to 64 breadth-first searches. Only the cells that received new bits at the
+ * previous level are expanded.
+ *
+ * The cells and moves are exactly those of the graph built by the
+ * ``map_graph`` module (see ``mapsearch_isFree``). The moves of every cell
+ * are computed once from the direction masks of the tiles, as a 27-bit mask
+ * whose bit ``b`` is set if the move in direction ``b`` leads to a cell that
+ * allows the opposite move. Since they are only read by the sweeps, several
+ * workspaces, one per thread, can share them (see ``mapreach_createShared``).
+ * The cells reached by a sweep are recorded, so that the next sweep only
+ * clears them instead of the whole map.
+ */
+#ifndef MAP_REACH_H
+#define MAP_REACH_H
+
+#include <stdint.h>
+#include "map.h"
+#include "map_graph.h"
+
+#define MAPREACH_MAX_SOURCES 64 // The number of starting cells of a sweep
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct MapReach {                // A workspace for sweeps on a map
+    const struct Map *map;       // The map
+    unsigned int numCells;       // The number of cells of the map
+    uint32_t *moves;             // The allowed moves of each cell
+    bool ownsMoves;              // If true, the moves are freed with the
+                                 // workspace
+    uint64_t *reached;           // The starting cells reaching each cell
+    uint64_t *visit;             // The bits received at the current level
+    uint64_t *visitNext;         // The bits received at the next level
+    unsigned int *frontier;      // The cells of the current level
+    unsigned int *nextFrontier;  // The cells of the next level
+    unsigned int *targetIndex;   // The first target of each cell, if any
+    unsigned int *touched;       // The cells reached by the last sweep
+    unsigned int numTouched;     // The number of cells reached by the last
+                                 // sweep
+};
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Creates a sweep workspace for the given map.
+ *
+ * The moves of the cells are computed from the current tiles of the map, so
+ * that the workspace must be created again if the map changes.
+ *
+ * @param map  The map
+ * @return     The workspace
+ */
+struct MapReach mapreach_create(const struct Map *map);
+
+/**
+ * Creates a sweep workspace sharing the moves of another one.
+ *
+ * The other workspace must not be deleted before the new one.
+ *
+ * @param reach  The workspace whose moves are shared
+ * @return       The new workspace
+ */
+struct MapReach mapreach_createShared(const struct MapReach *reach);
+
+/**
+ * Deletes the given workspace.
+ *
+ * @param reach  The workspace to delete
+ */
+void mapreach_delete(struct MapReach *reach);
+
+/**
+ * Sweeps the map from up to 64 starting cells at once.
+ *
+ * After the sweep, ``mapreach_sources`` tells which starting cells reach any
+ * cell of the map. Each target is attached to one of the starting cells,
+ * given by its number in ``targetSources``, and the number of moves between
+ * them is stored in ``distances`` (-1 if the target is not reached). The
+ * sweep stops as soon as every target is reached from its starting cell, so
+ * that any number of queries sharing at most 64 starting cells are answered
+ * by a single sweep.
+ *
+ * A starting cell that cannot be visited reaches no cell, not even itself.
+ *
+ * @param reach          The workspace
+ * @param sources        The starting cells
+ * @param numSources     The number of starting cells (at most 64)
+ * @param targets        The targets (may be NULL if numTargets is 0)
+ * @param targetSources  The starting cell of each target
+ * @param numTargets     The number of targets
+ * @param distances      The distance of each target from its starting cell
+ */
+void mapreach_search(struct MapReach *reach,
+                     const struct MapCell *sources,
+                     unsigned int numSources,
+                     const struct MapCell *targets,
+                     const unsigned int *targetSources,
+                     unsigned int numTargets,
+                     int *distances);
+
+/**
+ * Returns the starting cells of the last sweep that reach the given cell.
+ *
+ * If the sweep stopped early because every target was reached, the cells
+ * farther than the farthest target may be missing. Without targets, the
+ * sweep covers every cell reached.
+ *
+ * @param reach  The workspace
+ * @param cell   The cell
+ * @return       The bit of each starting cell reaching the cell
+ */
+uint64_t mapreach_sources(const struct MapReach *reach,
+                          const struct MapCell *cell);
+
+/**
+ * Returns true if the given cell is reached from a starting cell of the
+ * last sweep.
+ *
+ * @param reach   The workspace
+ * @param source  The number of the starting cell in the sweep
+ * @param cell    The cell
+ * @return        True if the cell is reached
+ */
+bool mapreach_isReachable(const struct MapReach *reach,
+                          unsigned int source,
+                          const struct MapCell *cell);
+
+#endif
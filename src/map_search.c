@@ -0,0 +1,172 @@
+#include <assert.h>
+#include "map_search.h"
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Returns the position of a cell in the arrays of a search.
+ *
+ * @param map     The map
+ * @param layer   The layer of the cell
+ * @param row     The row of the cell
+ * @param column  The column of the cell
+ * @return        The position of the cell
+ */
+unsigned int mapsearch_cellIndex(const struct Map *map,
+                                 unsigned int layer,
+                                 unsigned int row,
+                                 unsigned int column) {
+    return (layer * map->numRows + row) * map->numColumns + column;
+}
+
+/**
+ * Returns the cell at the given position in the arrays of a search.
+ *
+ * @param map    The map
+ * @param index  The position of the cell
+ * @return       The cell
+ */
+struct MapCell mapsearch_cellAt(const struct Map *map, unsigned int index) {
+    struct MapCell cell;
+    cell.column = index % map->numColumns;
+    cell.row = (index / map->numColumns) % map->numRows;
+    cell.layer = index / (map->numColumns * map->numRows);
+    return cell;
+}
+
+/**
+ * Returns the path ending at the given cell of a search.
+ *
+ * @param map           The map
+ * @param predecessors  The predecessor of each visited cell
+ * @param startIndex    The position of the starting cell
+ * @param endIndex      The position of the ending cell
+ * @return              The path from the starting cell to the ending cell
+ */
+struct MapGraphPath *mapsearch_retrievePath(const struct Map *map,
+                                            const unsigned int *predecessors,
+                                            unsigned int startIndex,
+                                            unsigned int endIndex) {
+    unsigned int numCells = 1;
+    for (unsigned int index = endIndex; index != startIndex;
+         index = predecessors[index]) {
+        ++numCells;
+    }
+    struct MapGraphPath *path = mapgraph_createPath(numCells);
+    unsigned int index = endIndex;
+    for (unsigned int i = numCells; i > 0; --i) {
+        path->cells[i - 1] = mapsearch_cellAt(map, index);
+        index = predecessors[index];
+    }
+    return path;
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+bool mapsearch_isFree(const struct Map *map, const struct MapCell *cell) {
+    return cell->layer  < map->numLayers &&
+           cell->row    < map->numRows &&
+           cell->column < map->numColumns &&
+           map_getTile(map, cell->layer, cell->row, cell->column) != 0 &&
+           !map_hasTileAbove(map, cell->row, cell->column, cell->layer);
+}
+
+struct MapGraphPath *mapsearch_shortestPath(const struct Map *map,
+                                            const struct MapCell *start,
+                                            const struct MapCell *end) {
+    struct MapSearch search = mapsearch_createSearch(map);
+    struct MapGraphPath *path = mapsearch_searchShortestPath(&search, start, end);
+    mapsearch_deleteSearch(&search);
+    return path;
+}
+
+struct MapSearch mapsearch_createSearch(const struct Map *map) {
+    struct MapSearch search;
+    unsigned int numCells = map->numLayers * map->numRows * map->numColumns;
+    search.map = map;
+    search.predecessors =
+        (unsigned int*)malloc(numCells * sizeof(unsigned int));
+    search.generations =
+        (unsigned int*)calloc(numCells, sizeof(unsigned int));
+    search.generation = 0;
+    search.queue = (unsigned int*)malloc(numCells * sizeof(unsigned int));
+    return search;
+}
+
+void mapsearch_deleteSearch(struct MapSearch *search) {
+    free(search->predecessors);
+    free(search->generations);
+    free(search->queue);
+    search->predecessors = NULL;
+    search->generations = NULL;
+    search->queue = NULL;
+}
+
+struct MapGraphPath *mapsearch_searchShortestPath(struct MapSearch *search,
+                                                  const struct MapCell *start,
+                                                  const struct MapCell *end) {
+    const struct Map *map = search->map;
+    assert(start->row    < map->numRows);
+    assert(start->column < map->numColumns);
+    assert(start->layer  < map->numLayers);
+    assert(end->row      < map->numRows);
+    assert(end->column   < map->numColumns);
+    assert(end->layer    < map->numLayers);
+    if (!mapsearch_isFree(map, start) || !mapsearch_isFree(map, end)) {
+        return NULL;
+    }
+    unsigned int *predecessors = search->predecessors;
+    unsigned int *generations = search->generations;
+    unsigned int *queue = search->queue;
+    if (++search->generation == 0) {
+        unsigned int numCells = map->numLayers * map->numRows * map->numColumns;
+        for (unsigned int i = 0; i < numCells; ++i) {
+            generations[i] = 0;
+        }
+        search->generation = 1;
+    }
+    unsigned int generation = search->generation;
+    unsigned int startIndex =
+        mapsearch_cellIndex(map, start->layer, start->row, start->column);
+    unsigned int endIndex =
+        mapsearch_cellIndex(map, end->layer, end->row, end->column);
+    unsigned int first = 0, last = 0;
+    queue[last++] = startIndex;
+    predecessors[startIndex] = startIndex;
+    generations[startIndex] = generation;
+    while (first < last && generations[endIndex] != generation) {
+        unsigned int index = queue[first++];
+        struct MapCell cell = mapsearch_cellAt(map, index);
+        const struct Tile *tile =
+            &map->tiles[map_getTile(map, cell.layer, cell.row, cell.column)];
+        for (uint32_t mask = tile->directionMask; mask != 0; mask &= mask - 1) {
+            unsigned int bit = map_firstDirection(mask);
+            struct Direction direction = map_bitDirection(bit);
+            struct MapCell neighbor = {
+                cell.row + direction.deltaRow,
+                cell.column + direction.deltaColumn,
+                cell.layer + direction.deltaLayer
+            };
+            if (!mapsearch_isFree(map, &neighbor)) continue;
+            unsigned int neighborIndex = index + map->directionOffsets[bit];
+            if (generations[neighborIndex] == generation) continue;
+            const struct Tile *neighborTile = &map->tiles[
+                map_getTile(map, neighbor.layer, neighbor.row, neighbor.column)];
+            if ((neighborTile->directionMask
+                 & ((uint32_t)1 << (MAP_NUM_DIRECTIONS - 1 - bit))) != 0) {
+                predecessors[neighborIndex] = index;
+                generations[neighborIndex] = generation;
+                queue[last++] = neighborIndex;
+            }
+        }
+    }
+    if (generations[endIndex] != generation) {
+        return NULL;
+    } else {
+        return mapsearch_retrievePath(map, predecessors, startIndex, endIndex);
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * Module map_search
+ *
+ * This module computes shortest paths directly on the layers of a map,
+ * without building its graph.
+ *
+ * The cells and moves considered are exactly those of the graph built by the
+ * ``map_graph`` module: a cell can be visited if it is not empty and has no
+ * tile above itself, and one can move from a cell to another if the tile of
+ * the first cell allows the move and the tile of the second cell allows the
+ * opposite move. The neighbors of a cell are derived from its tile whenever
+ * the cell is visited, so that a single query on a large map does not pay for
+ * the construction of the whole graph.
+ *
+ * As for the searches on a graph, the buffers of a search can be kept in a
+ * workspace and reused from one search to the next, each search stamping the
+ * cells it visits with its own generation number.
+ */
+#ifndef MAP_SEARCH_H
+#define MAP_SEARCH_H
+
+#include "map.h"
+#include "map_graph.h"
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct MapSearch {              // A search workspace on the cells of a map
+    const struct Map *map;      // The searched map
+    unsigned int *predecessors; // The predecessor of each cell
+    unsigned int *generations;  // The search that last visited each cell
+    unsigned int generation;    // The number of the current search
+    unsigned int *queue;        // The cells to visit, by order of visit
+};
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Returns true if the given cell can be visited.
+ *
+ * A cell can be visited if it belongs to the map, is not empty and has no
+ * tile above itself.
+ *
+ * @param map   The map
+ * @param cell  The cell to be checked
+ * @return      True if the cell can be visited
+ */
+bool mapsearch_isFree(const struct Map *map, const struct MapCell *cell);
+
+/**
+ * Returns a shortest path between two cells of the given map.
+ *
+ * The path is computed by a breadth-first search on the cells of the map,
+ * which stops as soon as the ending cell is reached. Its length is the same
+ * as the one of the path returned by ``mapgraph_shortestPath`` on the graph
+ * of the map.
+ *
+ * If such a path does not exist, then NULL is returned.
+ *
+ * @param map    The map
+ * @param start  The starting cell
+ * @param end    The ending cell
+ * @return       A shortest path between two cells
+ */
+struct MapGraphPath *mapsearch_shortestPath(const struct Map *map,
+                                            const struct MapCell *start,
+                                            const struct MapCell *end);
+
+/**
+ * Creates a search workspace for the given map.
+ *
+ * The workspace holds one entry per cell of the map, so that it can be reused
+ * as long as the dimensions of the map do not change. A workspace must not be
+ * shared between threads.
+ *
+ * @param map  The map to be searched
+ * @return     The workspace
+ */
+struct MapSearch mapsearch_createSearch(const struct Map *map);
+
+/**
+ * Deletes the given search workspace.
+ *
+ * @param search  The workspace to delete
+ */
+void mapsearch_deleteSearch(struct MapSearch *search);
+
+/**
+ * Returns a shortest path between two cells, using the given workspace.
+ *
+ * The result is the same as the one of ``mapsearch_shortestPath``, but the
+ * buffers are neither allocated nor cleared for the search.
+ *
+ * @param search  The search workspace
+ * @param start   The starting cell
+ * @param end     The ending cell
+ * @return        A shortest path between two cells
+ */
+struct MapGraphPath *mapsearch_searchShortestPath(struct MapSearch *search,
+                                                  const struct MapCell *start,
+                                                  const struct MapCell *end);
+
+#endif
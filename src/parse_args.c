@@ -31,6 +31,41 @@ enum Error castCoordinates(char *s, int *layer, int *row, int *column) {
     return numParsed == 3 && tail == '\0' ? TP2_OK : TP2_ERROR_COORDINATES;
 }
 
+/**
+ * Retrieves a positive number of threads from a string.
+ *
+ * @param s           The string containing the number
+ * @param numThreads  The given number of threads
+ */
+enum Error castNumThreads(char *s, int *numThreads) {
+    char tail = '\0';
+    int numParsed = sscanf(s, "%d%c", numThreads, &tail);
+    return numParsed == 1 && *numThreads > 0 ? TP2_OK : TP2_ERROR_NUM_THREADS;
+}
+
+/**
+ * Retrieves a nonnegative cache size from a string.
+ *
+ * @param s          The string containing the number
+ * @param cacheSize  The given cache size
+ */
+enum Error castCacheSize(char *s, int *cacheSize) {
+    char tail = '\0';
+    int numParsed = sscanf(s, "%d%c", cacheSize, &tail);
+    return numParsed == 1 && *cacheSize >= 0 ? TP2_OK : TP2_ERROR_CACHE_SIZE;
+}
+
+/**
+ * Retrieves a nonnegative number of moves from a string.
+ *
+ * @param s      The string containing the number
+ * @param range  The given number of moves
+ */
+enum Error castRange(char *s, int *range) {
+    char tail = '\0';
+    int numParsed = sscanf(s, "%d%c", range, &tail);
+    return numParsed == 1 && *range >= 0 ? TP2_OK : TP2_ERROR_RANGE;
+}
 
 int adequateJsonFormat(char filename[]) {
     int noTile = 0;
@@ -90,6 +125,20 @@ int adequateJsonFormat(char filename[]) {
                     if (json_object_get(tileType, "filename") == NULL || json_object_get(tileType, "directions") == NULL) {
                         return -1;
                     }
+                    json_t* directionsMap = json_object_get(tileType, "directions");
+                    for (size_t d = 0; d < json_array_size(directionsMap); ++d) {
+                        json_t* direction = json_array_get(directionsMap, d);
+                        for (size_t k = 0; k < 3; ++k) {
+                            json_int_t delta = json_integer_value(json_array_get(direction, k));
+                            if (delta < -1 || delta > 1) {
+                                return -1;
+                            }
+                        }
+                    }
+                    json_t* costMap = json_object_get(tileType, "cost");
+                    if (costMap != NULL && (!json_is_integer(costMap) || json_integer_value(costMap) < 1)) {
+                        return -1;
+                    }
                 }
             }
         }
@@ -128,13 +177,21 @@ struct Arguments parseArguments(int argc, char **argv) {
     strcpy(arguments.inputFilename, "");
     strcpy(arguments.outputFormat, "text");
     strcpy(arguments.outputFilename, "stdout");
+    strcpy(arguments.algorithm, "bfs");
+    strcpy(arguments.queriesFilename, "");
+    strcpy(arguments.nearestTile, "");
+    strcpy(arguments.landmarksFilename, "");
     arguments.startLayer  = 1;
     arguments.startRow    = 0;
     arguments.startColumn = 0;
     arguments.endLayer    = 1;
     arguments.endRow      = 1;
     arguments.endColumn   = 1;
+    arguments.numThreads  = 1;
+    arguments.cacheSize   = 0;
+    arguments.range       = -1;
     arguments.withSolution = false;
+    arguments.distancesOnly = false;
     arguments.showHelp = false;
     arguments.status = TP2_OK;
 
@@ -142,25 +199,35 @@ struct Arguments parseArguments(int argc, char **argv) {
         // Set flag
         {"help",            no_argument,       0, 'h'},
         {"with-solution",   no_argument,       0, 's'},
+        {"distances-only",  no_argument,       0, 'd'},
         // Don't set flag
         {"start",           required_argument, 0, 't'},
         {"end",             required_argument, 0, 'e'},
         {"input-filename",  required_argument, 0, 'i'},
         {"output-format",   required_argument, 0, 'f'},
         {"output-filename", required_argument, 0, 'o'},
+        {"algorithm",       required_argument, 0, 'a'},
+        {"queries",         required_argument, 0, 'q'},
+        {"threads",         required_argument, 0, 'n'},
+        {"cache-size",      required_argument, 0, 'c'},
+        {"nearest",         required_argument, 0, 'g'},
+        {"range",           required_argument, 0, 'k'},
+        {"landmarks",       required_argument, 0, 'l'},
         {0, 0, 0, 0}
     };
 
     // Parse options
     while (true) {
         int option_index = 0;
-        int c = getopt_long(argc, argv, "htesifo", longOpts, &option_index);
+        int c = getopt_long(argc, argv, "htesifoaqdncgkl", longOpts, &option_index);
         if (c == -1) break;
         switch (c) {
             case 'h': arguments.showHelp = true;
                       break;
             case 's': arguments.withSolution = true;
                       break;
+            case 'd': arguments.distancesOnly = true;
+                      break;
             case 't': arguments.status = castCoordinates(optarg,
                                                          &arguments.startLayer,
                                                          &arguments.startRow,
@@ -174,9 +241,30 @@ struct Arguments parseArguments(int argc, char **argv) {
             case 'i': strncpy(arguments.inputFilename, optarg, FILENAME_LENGTH);
                       break;
             case 'f': strncpy(arguments.outputFormat, optarg, FORMAT_LENGTH);
+                      arguments.outputFormat[FORMAT_LENGTH - 1] = '\0';
                       break;
             case 'o': strncpy(arguments.outputFilename, optarg, FILENAME_LENGTH);
                       break;
+            case 'a': strncpy(arguments.algorithm, optarg, ALGORITHM_LENGTH);
+                      arguments.algorithm[ALGORITHM_LENGTH - 1] = '\0';
+                      break;
+            case 'l': strncpy(arguments.landmarksFilename, optarg, FILENAME_LENGTH);
+                      arguments.landmarksFilename[FILENAME_LENGTH - 1] = '\0';
+                      break;
+            case 'k': arguments.status = castRange(optarg, &arguments.range);
+                      break;
+            case 'g': strncpy(arguments.nearestTile, optarg, TILE_NAME_LENGTH);
+                      arguments.nearestTile[TILE_NAME_LENGTH - 1] = '\0';
+                      break;
+            case 'q': strncpy(arguments.queriesFilename, optarg, FILENAME_LENGTH);
+                      arguments.queriesFilename[FILENAME_LENGTH - 1] = '\0';
+                      break;
+            case 'n': arguments.status = castNumThreads(optarg,
+                                                        &arguments.numThreads);
+                      break;
+            case 'c': arguments.status = castCacheSize(optarg,
+                                                       &arguments.cacheSize);
+                      break;
             case '?': arguments.status = TP2_ERROR_BAD_OPTION;
                       break;
         }
@@ -190,14 +278,32 @@ struct Arguments parseArguments(int argc, char **argv) {
         arguments.status = TP2_OK;
     } else if (arguments.status == TP2_ERROR_COORDINATES) {
         printf("Error: the coordinates must be integers separated by commas\n");
+    } else if (arguments.status == TP2_ERROR_NUM_THREADS) {
+        printf("Error: the number of threads must be a positive integer\n");
+    } else if (arguments.status == TP2_ERROR_CACHE_SIZE) {
+        printf("Error: the cache size must be a nonnegative integer\n");
+    } else if (arguments.status == TP2_ERROR_RANGE) {
+        printf("Error: the range must be a nonnegative integer\n");
     } else if (strcmp(arguments.outputFormat, "text") != 0
             && strcmp(arguments.outputFormat, "dot") != 0
-            && strcmp(arguments.outputFormat, "png") != 0) {
+            && strcmp(arguments.outputFormat, "png") != 0
+            && strcmp(arguments.outputFormat, "flowfield") != 0) {
         printf("Error: format %s not supported\n", arguments.outputFormat);
         arguments.status = TP2_ERROR_FORMAT_NOT_SUPPORTED;
-    } else if (strcmp(arguments.outputFormat, "png") == 0
+    } else if (strcmp(arguments.algorithm, "bfs") != 0
+            && strcmp(arguments.algorithm, "astar") != 0
+            && strcmp(arguments.algorithm, "bidir") != 0
+            && strcmp(arguments.algorithm, "grid") != 0
+            && strcmp(arguments.algorithm, "hpa") != 0
+            && strcmp(arguments.algorithm, "dijkstra") != 0
+            && strcmp(arguments.algorithm, "alt") != 0) {
+        printf("Error: algorithm %s not supported\n", arguments.algorithm);
+        arguments.status = TP2_ERROR_ALGORITHM_NOT_SUPPORTED;
+    } else if ((strcmp(arguments.outputFormat, "png") == 0
+             || strcmp(arguments.outputFormat, "flowfield") == 0)
             && strcmp(arguments.outputFilename, "stdout") == 0) {
-        printf("Error: output filename is mandatory with png format\n");
+        printf("Error: output filename is mandatory with %s format\n",
+               arguments.outputFormat);
         arguments.status = TP2_ERROR_PNG_FORMAT_WITHOUT_FILENAME;
     } else if (strcmp(arguments.inputFilename, "") == 0) {
         printf("Error: input filename is mandatory\n");
@@ -13,13 +13,18 @@
 
 #include <stdbool.h>
 
-#define FORMAT_LENGTH 5
+#define FORMAT_LENGTH 10
+#define ALGORITHM_LENGTH 10
 #define FILENAME_LENGTH 200
+#define TILE_NAME_LENGTH 50
 #define COLOR_LENGTH 15
 #define NUM_ROWS_DEFAULT 5
 #define NUM_COLS_DEFAULT 5
 #define USAGE "\
 Usage: %s [--help] [--start L,R,C] [--end L,R,C] [--with-solution]\n\
+    [--nearest STRING] [--range K] [--algorithm STRING]\n\
+    [--landmarks FILENAME] [--queries FILENAME] [--distances-only]\n\
+    [--threads N] [--cache-size N]\n\
     --input-filename FILENAME [--output-format STRING]\n\
     [--output-filename FILENAME]\n\
 \n\
@@ -40,11 +45,43 @@ Optional arguments:\n\
                            C the column.\n\
                            Default value is (1,1,1)\n\
   --with-solution          Also displays the solution in the map.\n\
+  --nearest STRING         With --with-solution, the solution goes from\n\
+                           the start point to the closest cell whose\n\
+                           tile is named STRING, instead of the end\n\
+                           point.\n\
+  --range K                Also highlights every cell that can be\n\
+                           reached from the start point in at most\n\
+                           K moves.\n\
+  --algorithm STRING       Selects the shortest path algorithm (either\n\
+                           \"bfs\", \"astar\", \"bidir\", \"grid\",\n\
+                           \"hpa\", \"dijkstra\" or \"alt\").\n\
+                           The default algorithm is \"bfs\".\n\
+  --landmarks FILENAME     With the \"alt\" algorithm, loads the\n\
+                           landmarks of the map from the given file,\n\
+                           or computes and saves them in it if the\n\
+                           file does not match the map.\n\
+  --queries FILENAME       Answers all the queries of the given file,\n\
+                           one \"L,R,C L,R,C\" pair of cells per line,\n\
+                           instead of producing the map.\n\
+  --distances-only         With --queries, writes the length of each\n\
+                           path (its cost with dijkstra) instead of\n\
+                           the path itself.\n\
+  --threads N              With --queries, the number of threads\n\
+                           answering the queries.\n\
+                           Default value is 1.\n\
+  --cache-size N           With --queries, keeps the N most recently\n\
+                           computed paths, so that repeated queries\n\
+                           are answered without searching again.\n\
+                           The statistics of the cache are written\n\
+                           on stderr. Default value is 0 (no cache).\n\
   --output-format STRING   Selects the ouput format (either \"text\",\n\
-                           \"dot\" or \"png\").\n\
+                           \"dot\", \"png\" or \"flowfield\").\n\
+                           The \"flowfield\" format writes, as a\n\
+                           binary grid, the distance and the move\n\
+                           of every cell toward the end point.\n\
                            The default format is \"text\".\n\
   --output-filename STRING The name of the output file.\n\
-                           Mandatory for png format.\n\
+                           Mandatory for png and flowfield formats.\n\
                            If not specified, displays on stdout.\n\
 "
 
@@ -57,18 +94,32 @@ enum Error {
     TP2_ERROR_BAD_OPTION                  = 4,
     TP2_ERROR_INPUT_FILENAME_MANDATORY    = 5,
     TP2_ERROR_JSON_FORMAT                 = 6,
+    TP2_ERROR_ALGORITHM_NOT_SUPPORTED     = 7,
+    TP2_ERROR_QUERIES_FORMAT              = 8,
+    TP2_ERROR_NUM_THREADS                 = 9,
+    TP2_ERROR_CACHE_SIZE                  = 10,
+    TP2_ERROR_RANGE                       = 11,
 };
 
 // Arguments
 struct Arguments {
     bool showHelp;                        // Shows help?
     bool withSolution;                    // Displays solution?
+    bool distancesOnly;                   // Writes only query distances?
     int startLayer;                       // The start layer
     int startRow;                         // The start row
     int startColumn;                      // The start column
     int endLayer;                         // The end layer
     int endRow;                           // The end row
     int endColumn;                        // The end column
+    int numThreads;                       // The number of query threads
+    int cacheSize;                        // The number of cached paths
+    int range;                            // The number of moves of the
+                                          // highlighted region (-1 if none)
+    char algorithm[ALGORITHM_LENGTH];     // The shortest path algorithm
+    char nearestTile[TILE_NAME_LENGTH];   // The tile of the closest target
+    char queriesFilename[FILENAME_LENGTH]; // The queries filename
+    char landmarksFilename[FILENAME_LENGTH]; // The landmarks filename
     char inputFilename[FILENAME_LENGTH];  // The input filename
     char outputFormat[FORMAT_LENGTH];     // The output format
     char outputFilename[FILENAME_LENGTH]; // The output filename
@@ -0,0 +1,327 @@
+#include <string.h>
+#include "path_cache.h"
+#include "map.h"
+
+#define PATHCACHE_NO_ENTRY ((unsigned int)-1) // Marks the absence of an entry
+#define PATHCACHE_MAX_SHARDS 16                // The maximum number of shards
+#define PATHCACHE_MIN_SHARD_CAPACITY 64        // The minimum number of paths
+                                               // held by each shard
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Returns a copy of the given path.
+ *
+ * @param path  The path to copy (possibly NULL)
+ * @return      The copy (NULL if the path is NULL)
+ */
+struct MapGraphPath *pathcache_copyPath(const struct MapGraphPath *path) {
+    if (path == NULL) return NULL;
+    struct MapGraphPath *copy = mapgraph_createPath(path->numCells);
+    memcpy(copy->cells, path->cells, path->numCells * sizeof(struct MapCell));
+    return copy;
+}
+
+/**
+ * Returns true if the two given cells are the same.
+ *
+ * @param cell1  The first cell
+ * @param cell2  The second cell
+ * @return       True if the cells are the same
+ */
+bool pathcache_sameCell(const struct MapCell *cell1,
+                        const struct MapCell *cell2) {
+    return cell1->layer  == cell2->layer &&
+           cell1->row    == cell2->row &&
+           cell1->column == cell2->column;
+}
+
+/**
+ * Returns the hash of the path between two cells.
+ *
+ * The version of the map is not hashed, so that the path computed on a new
+ * version of the map takes the place of the outdated one.
+ *
+ * @param start  The starting cell
+ * @param end    The ending cell
+ * @return       The hash of the path
+ */
+uint32_t pathcache_hash(const struct MapCell *start,
+                        const struct MapCell *end) {
+    unsigned int values[6] = {start->layer, start->row, start->column,
+                              end->layer, end->row, end->column};
+    uint32_t hash = 2166136261u;
+    for (unsigned int i = 0; i < 6; ++i) {
+        hash = (hash ^ values[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Returns the shard holding the path of the given hash.
+ *
+ * The shard is given by the highest bits of the hash, and the bucket by the
+ * lowest ones, so that the paths of a shard are spread over all its buckets.
+ *
+ * @param cache  The cache
+ * @param hash   The hash of the path
+ * @return       The shard of the path
+ */
+struct PathCacheShard *pathcache_shard(const struct PathCache *cache,
+                                       uint32_t hash) {
+    return &cache->shards[(uint32_t)(((uint64_t)hash * cache->numShards) >> 32)];
+}
+
+/**
+ * Returns the bucket of the path of the given hash.
+ *
+ * @param shard  The shard of the path
+ * @param hash   The hash of the path
+ * @return       The bucket of the path
+ */
+unsigned int pathcache_bucket(const struct PathCacheShard *shard,
+                              uint32_t hash) {
+    return (hash ^ (hash >> 16)) & (shard->numBuckets - 1);
+}
+
+/**
+ * Returns the entry of the path between two cells, of any version.
+ *
+ * @param shard  The shard of the path
+ * @param hash   The hash of the path
+ * @param start  The starting cell
+ * @param end    The ending cell
+ * @return       The entry, or PATHCACHE_NO_ENTRY if there is none
+ */
+unsigned int pathcache_findEntry(const struct PathCacheShard *shard,
+                                 uint32_t hash,
+                                 const struct MapCell *start,
+                                 const struct MapCell *end) {
+    unsigned int e = shard->buckets[pathcache_bucket(shard, hash)];
+    while (e != PATHCACHE_NO_ENTRY &&
+           (!pathcache_sameCell(&shard->entries[e].start, start) ||
+            !pathcache_sameCell(&shard->entries[e].end, end))) {
+        e = shard->entries[e].nextInBucket;
+    }
+    return e;
+}
+
+/**
+ * Removes an entry from the list of recently used entries.
+ *
+ * @param shard  The shard of the entry
+ * @param e      The entry to remove
+ */
+void pathcache_unlink(struct PathCacheShard *shard, unsigned int e) {
+    struct PathCacheEntry *entry = &shard->entries[e];
+    if (entry->previous != PATHCACHE_NO_ENTRY) {
+        shard->entries[entry->previous].next = entry->next;
+    } else {
+        shard->first = entry->next;
+    }
+    if (entry->next != PATHCACHE_NO_ENTRY) {
+        shard->entries[entry->next].previous = entry->previous;
+    } else {
+        shard->last = entry->previous;
+    }
+}
+
+/**
+ * Puts an entry at the front of the list of recently used entries.
+ *
+ * @param shard  The shard of the entry
+ * @param e      The entry, which is not in the list
+ */
+void pathcache_pushFront(struct PathCacheShard *shard, unsigned int e) {
+    struct PathCacheEntry *entry = &shard->entries[e];
+    entry->previous = PATHCACHE_NO_ENTRY;
+    entry->next = shard->first;
+    if (shard->first != PATHCACHE_NO_ENTRY) {
+        shard->entries[shard->first].previous = e;
+    } else {
+        shard->last = e;
+    }
+    shard->first = e;
+}
+
+/**
+ * Removes an entry from its bucket.
+ *
+ * @param shard  The shard of the entry
+ * @param e      The entry to remove
+ */
+void pathcache_removeFromBucket(struct PathCacheShard *shard, unsigned int e) {
+    struct PathCacheEntry *entry = &shard->entries[e];
+    unsigned int *link = &shard->buckets[
+        pathcache_bucket(shard, pathcache_hash(&entry->start, &entry->end))];
+    while (*link != e) {
+        link = &shard->entries[*link].nextInBucket;
+    }
+    *link = entry->nextInBucket;
+}
+
+/**
+ * Initializes an empty shard.
+ *
+ * @param shard     The shard
+ * @param capacity  The maximum number of paths in the shard (at least 1)
+ */
+void pathcache_createShard(struct PathCacheShard *shard,
+                           unsigned int capacity) {
+    shard->capacity = capacity;
+    shard->numEntries = 0;
+    shard->entries = (struct PathCacheEntry*)malloc(capacity
+                                                    * sizeof(struct PathCacheEntry));
+    shard->numBuckets = 1;
+    while (shard->numBuckets < 2 * capacity) shard->numBuckets *= 2;
+    shard->buckets =
+        (unsigned int*)malloc(shard->numBuckets * sizeof(unsigned int));
+    for (unsigned int b = 0; b < shard->numBuckets; ++b) {
+        shard->buckets[b] = PATHCACHE_NO_ENTRY;
+    }
+    shard->first = PATHCACHE_NO_ENTRY;
+    shard->last = PATHCACHE_NO_ENTRY;
+    shard->numHits = 0;
+    shard->numMisses = 0;
+    pthread_mutex_init(&shard->mutex, NULL);
+}
+
+/**
+ * Deletes the given shard and the paths it holds.
+ *
+ * @param shard  The shard to delete
+ */
+void pathcache_deleteShard(struct PathCacheShard *shard) {
+    for (unsigned int e = 0; e < shard->numEntries; ++e) {
+        mapgraph_deletePath(shard->entries[e].path);
+    }
+    free(shard->entries);
+    free(shard->buckets);
+    pthread_mutex_destroy(&shard->mutex);
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+struct PathCache pathcache_create(unsigned int capacity) {
+    struct PathCache cache;
+    if (capacity == 0) capacity = 1;
+    cache.capacity = capacity;
+    cache.numShards = 1;
+    while (2 * cache.numShards <= PATHCACHE_MAX_SHARDS &&
+           capacity / (2 * cache.numShards) >= PATHCACHE_MIN_SHARD_CAPACITY) {
+        cache.numShards *= 2;
+    }
+    cache.shards = (struct PathCacheShard*)malloc(cache.numShards
+                                                  * sizeof(struct PathCacheShard));
+    for (unsigned int s = 0; s < cache.numShards; ++s) {
+        pathcache_createShard(&cache.shards[s], capacity / cache.numShards
+                              + (s < capacity % cache.numShards ? 1 : 0));
+    }
+    return cache;
+}
+
+void pathcache_delete(struct PathCache *cache) {
+    for (unsigned int s = 0; s < cache->numShards; ++s) {
+        pathcache_deleteShard(&cache->shards[s]);
+    }
+    free(cache->shards);
+    cache->shards = NULL;
+    cache->numShards = 0;
+}
+
+bool pathcache_lookup(struct PathCache *cache,
+                      unsigned int version,
+                      const struct MapCell *start,
+                      const struct MapCell *end,
+                      struct MapGraphPath **path) {
+    uint32_t hash = pathcache_hash(start, end);
+    struct PathCacheShard *shard = pathcache_shard(cache, hash);
+    pthread_mutex_lock(&shard->mutex);
+    unsigned int e = pathcache_findEntry(shard, hash, start, end);
+    bool found = e != PATHCACHE_NO_ENTRY && shard->entries[e].version == version;
+    if (found) {
+        ++shard->numHits;
+        pathcache_unlink(shard, e);
+        pathcache_pushFront(shard, e);
+        *path = pathcache_copyPath(shard->entries[e].path);
+    } else {
+        ++shard->numMisses;
+        *path = NULL;
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    return found;
+}
+
+void pathcache_insert(struct PathCache *cache,
+                      unsigned int version,
+                      const struct MapCell *start,
+                      const struct MapCell *end,
+                      const struct MapGraphPath *path) {
+    struct MapGraphPath *copy = pathcache_copyPath(path);
+    uint32_t hash = pathcache_hash(start, end);
+    struct PathCacheShard *shard = pathcache_shard(cache, hash);
+    pthread_mutex_lock(&shard->mutex);
+    unsigned int e = pathcache_findEntry(shard, hash, start, end);
+    if (e != PATHCACHE_NO_ENTRY) {
+        pathcache_unlink(shard, e);
+    } else {
+        if (shard->numEntries < shard->capacity) {
+            e = shard->numEntries++;
+        } else {
+            e = shard->last;
+            pathcache_unlink(shard, e);
+            pathcache_removeFromBucket(shard, e);
+            mapgraph_deletePath(shard->entries[e].path);
+        }
+        unsigned int b = pathcache_bucket(shard, hash);
+        shard->entries[e].start = *start;
+        shard->entries[e].end = *end;
+        shard->entries[e].path = NULL;
+        shard->entries[e].nextInBucket = shard->buckets[b];
+        shard->buckets[b] = e;
+    }
+    mapgraph_deletePath(shard->entries[e].path);
+    shard->entries[e].path = copy;
+    shard->entries[e].version = version;
+    pathcache_pushFront(shard, e);
+    pthread_mutex_unlock(&shard->mutex);
+}
+
+struct MapGraphPath *pathcache_shortestPath(struct PathCache *cache,
+                                            const struct MapGraph *graph,
+                                            const struct MapCell *start,
+                                            const struct MapCell *end) {
+    struct MapGraphPath *path;
+    if (!pathcache_lookup(cache, graph->version, start, end, &path)) {
+        path = mapgraph_shortestPath(graph, start, end);
+        pathcache_insert(cache, graph->version, start, end, path);
+    }
+    return path;
+}
+
+struct PathCacheStatistics pathcache_statistics(struct PathCache *cache) {
+    struct PathCacheStatistics statistics = {0, 0, 0};
+    for (unsigned int s = 0; s < cache->numShards; ++s) {
+        struct PathCacheShard *shard = &cache->shards[s];
+        pthread_mutex_lock(&shard->mutex);
+        statistics.numEntries += shard->numEntries;
+        statistics.numHits += shard->numHits;
+        statistics.numMisses += shard->numMisses;
+        pthread_mutex_unlock(&shard->mutex);
+    }
+    return statistics;
+}
+
+void pathcache_printStatistics(FILE *outputFile, struct PathCache *cache) {
+    struct PathCacheStatistics statistics = pathcache_statistics(cache);
+    unsigned long numLookups = statistics.numHits + statistics.numMisses;
+    fprintf(outputFile, "Path cache: %lu hits, %lu misses (%.1f%% hits), "
+                        "%u of %u paths stored\n",
+            statistics.numHits, statistics.numMisses,
+            numLookups == 0 ? 0.0 : 100.0 * statistics.numHits / numLookups,
+            statistics.numEntries, cache->capacity);
+}
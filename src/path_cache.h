@@ -0,0 +1,172 @@
+/**
+ * Module path_cache
+ *
+ * This module keeps the most recently computed shortest paths, so that a
+ * route asked many times (for instance from a spawn point to an objective)
+ * is computed only once.
+ *
+ * The cache holds a bounded number of paths. Each path is identified by its
+ * starting cell, its ending cell and the version of the map (see
+ * ``map_setTile``) from which its graph was built. A path computed before the
+ * map was edited is therefore never returned, and is eventually replaced.
+ * When the cache is full, the least recently used path is discarded.
+ *
+ * The paths are found through a hash table, and the entries of the cache are
+ * linked from the most recently used to the least recently used, so that a
+ * lookup and an insertion are done in constant time.
+ *
+ * Every function of the module can be called by several threads sharing the
+ * same cache. So that the threads do not wait for each other on every
+ * lookup, a large cache is split into shards, each having its own lock, its
+ * own hash table and its own order of use, and a path is always kept in the
+ * shard given by its cells. The least recently used path is then discarded
+ * from the shard of the new path only.
+ *
+ * The numbers of lookups that found a path (hits) and that did not (misses)
+ * are counted, so that the capacity of the cache can be chosen for the
+ * actual queries.
+ */
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "map_graph.h"
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct PathCacheEntry {        // A cached path
+    struct MapCell start;      // The starting cell
+    struct MapCell end;        // The ending cell
+    unsigned int version;      // The version of the map
+    struct MapGraphPath *path; // The path (NULL if there is no path)
+    unsigned int nextInBucket; // The next entry of the same bucket
+    unsigned int previous;     // The more recently used entry
+    unsigned int next;         // The less recently used entry
+};
+
+struct PathCacheShard {             // A part of a cache of shortest paths
+    struct PathCacheEntry *entries; // The entries
+    unsigned int numEntries;        // The number of entries
+    unsigned int capacity;          // The maximum number of entries
+    unsigned int *buckets;          // The first entry of each bucket
+    unsigned int numBuckets;        // The number of buckets (a power of 2)
+    unsigned int first;             // The most recently used entry
+    unsigned int last;              // The least recently used entry
+    unsigned long numHits;          // The number of lookups finding a path
+    unsigned long numMisses;        // The number of lookups finding none
+    pthread_mutex_t mutex;          // Protects the shard
+};
+
+struct PathCache {                  // A cache of shortest paths
+    struct PathCacheShard *shards;  // The shards
+    unsigned int numShards;         // The number of shards (a power of 2)
+    unsigned int capacity;          // The maximum number of entries
+};
+
+struct PathCacheStatistics {        // The statistics of a cache
+    unsigned int numEntries;        // The number of entries
+    unsigned long numHits;          // The number of lookups finding a path
+    unsigned long numMisses;        // The number of lookups finding none
+};
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Creates an empty cache.
+ *
+ * The cache is split into at most 16 shards, each holding at least 64 paths,
+ * so that a small cache has a single shard and discards exactly its least
+ * recently used path.
+ *
+ * @param capacity  The maximum number of paths in the cache (at least 1)
+ * @return          The cache
+ */
+struct PathCache pathcache_create(unsigned int capacity);
+
+/**
+ * Deletes the given cache and the paths it holds.
+ *
+ * @param cache  The cache to delete
+ */
+void pathcache_delete(struct PathCache *cache);
+
+/**
+ * Looks for the path between two cells of the given version of a map.
+ *
+ * If the path is found, a copy of it is stored in ``path``, which is NULL if
+ * the cells are not connected. The copy must be deleted by the caller.
+ *
+ * @param cache    The cache
+ * @param version  The version of the map
+ * @param start    The starting cell
+ * @param end      The ending cell
+ * @param path     The copy of the found path
+ * @return         True if the path was found
+ */
+bool pathcache_lookup(struct PathCache *cache,
+                      unsigned int version,
+                      const struct MapCell *start,
+                      const struct MapCell *end,
+                      struct MapGraphPath **path);
+
+/**
+ * Stores the path between two cells of the given version of a map.
+ *
+ * The cache stores its own copy of the path, which may be NULL if the cells
+ * are not connected.
+ *
+ * @param cache    The cache
+ * @param version  The version of the map
+ * @param start    The starting cell
+ * @param end      The ending cell
+ * @param path     The path
+ */
+void pathcache_insert(struct PathCache *cache,
+                      unsigned int version,
+                      const struct MapCell *start,
+                      const struct MapCell *end,
+                      const struct MapGraphPath *path);
+
+/**
+ * Returns a shortest path between two cells, computing it with
+ * ``mapgraph_shortestPath`` only if it is not in the cache.
+ *
+ * The path is identified by the version of the map from which the graph was
+ * built.
+ *
+ * The returned path must be deleted by the caller.
+ *
+ * @param cache  The cache
+ * @param graph  The graph of the map
+ * @param start  The starting cell
+ * @param end    The ending cell
+ * @return       A shortest path between two cells
+ */
+struct MapGraphPath *pathcache_shortestPath(struct PathCache *cache,
+                                            const struct MapGraph *graph,
+                                            const struct MapCell *start,
+                                            const struct MapCell *end);
+
+/**
+ * Returns the numbers of entries, hits and misses of the given cache.
+ *
+ * @param cache  The cache
+ * @return       The statistics of the cache
+ */
+struct PathCacheStatistics pathcache_statistics(struct PathCache *cache);
+
+/**
+ * Prints the number of hits and misses of the given cache.
+ *
+ * @param outputFile  The file to which the statistics are written
+ * @param cache       The cache
+ */
+void pathcache_printStatistics(FILE *outputFile, struct PathCache *cache);
+
+#endif
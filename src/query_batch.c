@@ -0,0 +1,620 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "query_batch.h"
+#include "map.h"
+#include "map_hierarchy.h"
+#include "map_landmarks.h"
+#include "map_reach.h"
+#include "map_search.h"
+#include "path_cache.h"
+
+#define LINE_LENGTH 256
+#define BLOCK_SIZE 4096 // The number of queries answered between two writes
+#define CHUNK_SIZE 16   // The number of queries taken at once by a worker
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct QueryTask {                         // The work shared by the workers
+    const struct MapGraph *graph;          // The graph of the map
+    const struct MapHierarchy *hierarchy;  // The chunks of the map (only for
+                                           // hierarchical search)
+    const struct MapLandmarks *landmarks;  // The landmarks of the map (only
+                                           // for ALT search)
+    const struct QueryBatch *batch;        // The queries
+    enum MapGraphAlgorithm algorithm;      // The algorithm computing the paths
+    struct PathCache *cache;               // The recently computed paths (NULL
+                                           // if there is no cache)
+    struct MapGraphPath **paths;           // The answers of the current block
+    int *distances;                        // The distances of the current
+                                           // block (NULL unless the queries
+                                           // are answered by sweeps)
+    unsigned int *order;                   // The queries of the current block,
+                                           // by position of their starting
+                                           // cell (only for sweeps)
+    unsigned int *groups;                  // The position in the order of
+                                           // the first query of each group
+                                           // (only for sweeps)
+    unsigned int numGroups;                // The number of groups
+    unsigned int first;                    // The first query of the block
+    unsigned int last;                     // The query following the block
+    unsigned int next;                     // The next query (or group) to be
+                                           // answered
+    unsigned int block;                    // The number of the current block
+    unsigned int numBusy;                  // The number of worker threads
+                                           // still answering the block
+    bool finished;                         // True once every block is answered
+    pthread_mutex_t mutex;                 // Protects the next query and the
+                                           // state of the block
+    pthread_cond_t blockStarted;           // Signaled when a block starts or
+                                           // when the batch is finished
+    pthread_cond_t blockAnswered;          // Signaled when the worker threads
+                                           // are done with the block
+};
+
+struct QueryKey {         // The position of the starting cell of a query
+    uint64_t key;         // The position of the cell along a Z-order curve
+    struct MapCell start; // The starting cell
+    unsigned int query;   // The query
+};
+
+struct QueryWorker {                   // A worker answering queries
+    struct QueryTask *task;            // The shared work
+    struct MapGraphSearch search;      // The search workspace of the worker
+                                       // (unless searching the grid)
+    struct MapGraphSearch backward;    // The backward search workspace
+                                       // (only for bidirectional search)
+    struct MapSearch grid;             // The grid search workspace (only
+                                       // for implicit search)
+    struct MapReach reach;             // The sweep workspace of the worker
+                                       // (only when answering by sweeps)
+    pthread_t thread;                  // The thread of the worker
+};
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Parses a query from a line of text.
+ *
+ * @param line   The line
+ * @param query  The parsed query
+ * @return       1 if a query was parsed, 0 if the line is blank and -1 if
+ *               the line is invalid
+ */
+int querybatch_parseLine(const char *line, struct Query *query) {
+    char tail = '\0';
+    int numParsed = sscanf(line, " %u,%u,%u %u,%u,%u %c",
+                           &query->start.layer,
+                           &query->start.row,
+                           &query->start.column,
+                           &query->end.layer,
+                           &query->end.row,
+                           &query->end.column,
+                           &tail);
+    if (numParsed == EOF) {
+        return 0;
+    } else {
+        return numParsed == 6 ? 1 : -1;
+    }
+}
+
+/**
+ * Adds a query to the given batch.
+ *
+ * @param batch  The batch
+ * @param query  The query to add
+ */
+void querybatch_addQuery(struct QueryBatch *batch, const struct Query *query) {
+    if (batch->numQueries == batch->capacity) {
+        batch->capacity *= 2;
+        batch->queries = realloc(batch->queries,
+                                 batch->capacity * sizeof(struct Query));
+    }
+    batch->queries[batch->numQueries] = *query;
+    ++batch->numQueries;
+}
+
+/**
+ * Computes the answer of a single query.
+ *
+ * @param worker  The worker answering the query
+ * @param query   The query
+ * @return        A shortest path, or NULL if there is none
+ */
+struct MapGraphPath *querybatch_computeAnswer(struct QueryWorker *worker,
+                                              const struct Query *query) {
+    const struct QueryTask *task = worker->task;
+    if (!mapgraph_hasCell(task->graph, &query->start) ||
+        !mapgraph_hasCell(task->graph, &query->end) ||
+        !mapgraph_areConnected(task->graph, &query->start, &query->end)) {
+        return NULL;
+    }
+    switch (task->algorithm) {
+        case MAPGRAPH_ASTAR:
+            return mapgraph_searchShortestPathAStar(&worker->search,
+                                                    &query->start, &query->end);
+        case MAPGRAPH_BIDIRECTIONAL:
+            return mapgraph_searchShortestPathBidirectional(&worker->search,
+                                                            &worker->backward,
+                                                            &query->start,
+                                                            &query->end);
+        case MAPGRAPH_DIJKSTRA:
+            return mapgraph_searchShortestPathDijkstra(&worker->search,
+                                                       &query->start,
+                                                       &query->end);
+        case MAPGRAPH_HIERARCHICAL:
+            return maphierarchy_shortestPath(task->hierarchy, &worker->search,
+                                             &query->start, &query->end);
+        case MAPGRAPH_ALT:
+            return maplandmarks_shortestPath(task->landmarks, &worker->search,
+                                             &query->start, &query->end);
+        case MAPGRAPH_IMPLICIT:
+            return mapsearch_searchShortestPath(&worker->grid,
+                                                &query->start, &query->end);
+        default:
+            assert(task->algorithm == MAPGRAPH_BFS);
+            return mapgraph_searchShortestPath(&worker->search,
+                                               &query->start, &query->end);
+    }
+}
+
+/**
+ * Answers a single query, using the cache of the task if there is one.
+ *
+ * @param worker  The worker answering the query
+ * @param query   The query
+ * @return        A shortest path, or NULL if there is none
+ */
+struct MapGraphPath *querybatch_answer(struct QueryWorker *worker,
+                                       const struct Query *query) {
+    struct PathCache *cache = worker->task->cache;
+    unsigned int version = worker->task->graph->version;
+    struct MapGraphPath *path;
+    if (cache == NULL) {
+        path = querybatch_computeAnswer(worker, query);
+    } else if (!pathcache_lookup(cache, version,
+                                 &query->start, &query->end, &path)) {
+        path = querybatch_computeAnswer(worker, query);
+        pathcache_insert(cache, version, &query->start, &query->end, path);
+    }
+    return path;
+}
+
+/**
+ * Returns the position of a cell along a Z-order curve.
+ *
+ * The bits of the row and of the column are interleaved, so that cells that
+ * are close on the map are usually close along the curve.
+ *
+ * @param cell  The cell
+ * @return      The position of the cell
+ */
+uint64_t querybatch_zOrder(const struct MapCell *cell) {
+    uint64_t key = 0;
+    for (unsigned int b = 0; b < 16; ++b) {
+        key |= (uint64_t)(cell->column >> b & 1) << (2 * b);
+        key |= (uint64_t)(cell->row >> b & 1) << (2 * b + 1);
+    }
+    return (uint64_t)cell->layer << 32 | key;
+}
+
+/**
+ * Compares two queries by the position of their starting cell.
+ *
+ * Since the position only uses the low bits of the rows and columns, ties
+ * are broken by the cells themselves, so that the queries sharing a starting
+ * cell are always next to each other.
+ *
+ * @param key1  The first query
+ * @param key2  The second query
+ * @return      A negative, zero or positive number, as for qsort
+ */
+int querybatch_compareKeys(const void *key1, const void *key2) {
+    const struct QueryKey *first = (const struct QueryKey*)key1;
+    const struct QueryKey *second = (const struct QueryKey*)key2;
+    if (first->key != second->key) return first->key < second->key ? -1 : 1;
+    if (first->start.layer != second->start.layer) {
+        return first->start.layer < second->start.layer ? -1 : 1;
+    }
+    if (first->start.row != second->start.row) {
+        return first->start.row < second->start.row ? -1 : 1;
+    }
+    if (first->start.column != second->start.column) {
+        return first->start.column < second->start.column ? -1 : 1;
+    }
+    return first->query < second->query ? -1 : first->query > second->query;
+}
+
+/**
+ * Returns true if the given cells are the same.
+ *
+ * @param cell1  The first cell
+ * @param cell2  The second cell
+ * @return       True if the cells are the same
+ */
+bool querybatch_sameCell(const struct MapCell *cell1,
+                         const struct MapCell *cell2) {
+    return cell1->layer  == cell2->layer &&
+           cell1->row    == cell2->row &&
+           cell1->column == cell2->column;
+}
+
+/**
+ * Orders the queries of the current block by their starting cell and splits
+ * them into groups having at most 64 starting cells.
+ *
+ * Queries whose starting cells are close are thus answered by the same
+ * sweep, where their searches advance together over most of the map.
+ *
+ * @param task  The task
+ */
+void querybatch_groupBlock(struct QueryTask *task) {
+    unsigned int numQueries = task->last - task->first;
+    struct QueryKey *keys =
+        (struct QueryKey*)malloc(numQueries * sizeof(struct QueryKey));
+    for (unsigned int i = 0; i < numQueries; ++i) {
+        keys[i].start = task->batch->queries[task->first + i].start;
+        keys[i].key = querybatch_zOrder(&keys[i].start);
+        keys[i].query = task->first + i;
+    }
+    qsort(keys, numQueries, sizeof(struct QueryKey), querybatch_compareKeys);
+    task->numGroups = 0;
+    unsigned int numSources = 0;
+    for (unsigned int i = 0; i < numQueries; ++i) {
+        task->order[i] = keys[i].query;
+        if (i == 0 ||
+            !querybatch_sameCell(&keys[i].start, &keys[i - 1].start)) {
+            if (numSources % MAPREACH_MAX_SOURCES == 0) {
+                task->groups[task->numGroups++] = i;
+            }
+            ++numSources;
+        }
+    }
+    task->groups[task->numGroups] = numQueries;
+    free(keys);
+}
+
+/**
+ * Computes the distances of a group of queries of the current block.
+ *
+ * The queries whose cells are not connected are answered first, without any
+ * search. The other ones are answered by a single sweep if their starting
+ * cells are shared by at least two queries on average. Otherwise, separate
+ * searches stopping at the ending cells are faster, and each query is
+ * searched alone. A group having more than 64 starting cells is also
+ * searched query by query.
+ *
+ * @param worker  The worker answering the queries
+ * @param group   The group
+ */
+void querybatch_answerGroup(struct QueryWorker *worker, unsigned int group) {
+    struct QueryTask *task = worker->task;
+    const struct MapGraph *graph = task->graph;
+    unsigned int first = task->groups[group];
+    unsigned int numQueries = task->groups[group + 1] - first;
+    struct MapCell sources[MAPREACH_MAX_SOURCES];
+    struct MapCell *targets =
+        (struct MapCell*)malloc(numQueries * sizeof(struct MapCell));
+    unsigned int *targetSources =
+        (unsigned int*)malloc(numQueries * sizeof(unsigned int));
+    unsigned int *targetQueries =
+        (unsigned int*)malloc(numQueries * sizeof(unsigned int));
+    int *distances = (int*)malloc(numQueries * sizeof(int));
+    unsigned int numSources = 0;
+    unsigned int numTargets = 0;
+    bool sweep = true;
+    for (unsigned int q = 0; q < numQueries; ++q) {
+        const struct Query *query =
+            &task->batch->queries[task->order[first + q]];
+        task->distances[task->order[first + q] - task->first] = -1;
+        if (!mapgraph_hasCell(graph, &query->start) ||
+            !mapgraph_hasCell(graph, &query->end) ||
+            !mapgraph_areConnected(graph, &query->start, &query->end)) {
+            continue;
+        }
+        if (numSources == 0 ||
+            !querybatch_sameCell(&sources[numSources - 1], &query->start)) {
+            if (numSources == MAPREACH_MAX_SOURCES) {
+                sweep = false;
+            } else {
+                sources[numSources++] = query->start;
+            }
+        }
+        targets[numTargets] = query->end;
+        targetSources[numTargets] = numSources - 1;
+        targetQueries[numTargets] = task->order[first + q];
+        ++numTargets;
+    }
+    if (sweep && numTargets >= 2 * numSources) {
+        mapreach_search(&worker->reach, sources, numSources,
+                        targets, targetSources, numTargets, distances);
+    } else {
+        for (unsigned int t = 0; t < numTargets; ++t) {
+            struct MapGraphPath *path = querybatch_computeAnswer(worker,
+                &task->batch->queries[targetQueries[t]]);
+            distances[t] = mapgraph_pathLength(path);
+            mapgraph_deletePath(path);
+        }
+    }
+    for (unsigned int t = 0; t < numTargets; ++t) {
+        task->distances[targetQueries[t] - task->first] = distances[t];
+    }
+    free(targets);
+    free(targetSources);
+    free(targetQueries);
+    free(distances);
+}
+
+/**
+ * Answers queries of the current block until none is left.
+ *
+ * The queries are taken by chunks from the shared task, and each answer is
+ * stored at the position of its query in the block. When the queries are
+ * answered by sweeps, the groups of queries are taken one at a time.
+ *
+ * @param worker  The worker
+ */
+void querybatch_work(struct QueryWorker *worker) {
+    struct QueryTask *task = worker->task;
+    while (task->distances != NULL) {
+        pthread_mutex_lock(&task->mutex);
+        unsigned int group = task->next++;
+        pthread_mutex_unlock(&task->mutex);
+        if (group >= task->numGroups) return;
+        querybatch_answerGroup(worker, group);
+    }
+    while (true) {
+        pthread_mutex_lock(&task->mutex);
+        unsigned int first = task->next;
+        unsigned int last = first + CHUNK_SIZE < task->last ?
+            first + CHUNK_SIZE : task->last;
+        task->next = last;
+        pthread_mutex_unlock(&task->mutex);
+        if (first >= last) break;
+        for (unsigned int i = first; i < last; ++i) {
+            task->paths[i - task->first] =
+                querybatch_answer(worker, &task->batch->queries[i]);
+        }
+    }
+}
+
+/**
+ * Answers the blocks of the batch in a worker thread, until it is finished.
+ *
+ * The thread waits for each block to be started by the main thread, takes
+ * part in answering it, and reports when it is done, so that the threads
+ * and their workspaces are kept for the whole batch.
+ *
+ * @param argument  The worker
+ * @return          NULL
+ */
+void *querybatch_serve(void *argument) {
+    struct QueryWorker *worker = (struct QueryWorker*)argument;
+    struct QueryTask *task = worker->task;
+    unsigned int block = 0;
+    pthread_mutex_lock(&task->mutex);
+    while (true) {
+        while (!task->finished && task->block == block) {
+            pthread_cond_wait(&task->blockStarted, &task->mutex);
+        }
+        if (task->finished) break;
+        block = task->block;
+        pthread_mutex_unlock(&task->mutex);
+        querybatch_work(worker);
+        pthread_mutex_lock(&task->mutex);
+        if (--task->numBusy == 0) {
+            pthread_cond_signal(&task->blockAnswered);
+        }
+    }
+    pthread_mutex_unlock(&task->mutex);
+    return NULL;
+}
+
+/**
+ * Writes the answer of a query.
+ *
+ * The distance is the total cost of the path with Dijkstra's algorithm, which
+ * minimizes that cost, and its number of moves otherwise.
+ *
+ * @param task           The task
+ * @param path           The answer of the query
+ * @param distancesOnly  If true, writes the distance instead of the path
+ * @param outputFile     The file to which the answer is written
+ */
+void querybatch_writeAnswer(const struct QueryTask *task,
+                            const struct MapGraphPath *path,
+                            bool distancesOnly,
+                            FILE *outputFile) {
+    if (distancesOnly && task->algorithm == MAPGRAPH_DIJKSTRA) {
+        fprintf(outputFile, "%d\n", mapgraph_pathCost(task->graph, path));
+    } else if (distancesOnly) {
+        fprintf(outputFile, "%d\n", mapgraph_pathLength(path));
+    } else {
+        mapgraph_writePath(outputFile, path);
+        fprintf(outputFile, "\n");
+    }
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+struct QueryBatch *querybatch_load(const char *filename) {
+    FILE *inputFile = fopen(filename, "r");
+    if (inputFile == NULL) return NULL;
+    struct QueryBatch *batch =
+        (struct QueryBatch*)malloc(sizeof(struct QueryBatch));
+    batch->queries = (struct Query*)malloc(sizeof(struct Query));
+    batch->numQueries = 0;
+    batch->capacity = 1;
+    char line[LINE_LENGTH];
+    while (fgets(line, LINE_LENGTH, inputFile) != NULL) {
+        struct Query query;
+        int status = querybatch_parseLine(line, &query);
+        if (status == 1) {
+            querybatch_addQuery(batch, &query);
+        } else if (status == -1) {
+            querybatch_delete(batch);
+            batch = NULL;
+            break;
+        }
+    }
+    fclose(inputFile);
+    return batch;
+}
+
+void querybatch_delete(struct QueryBatch *batch) {
+    if (batch != NULL) {
+        free(batch->queries);
+        free(batch);
+    }
+}
+
+void querybatch_run(const struct MapGraph *graph,
+                    const struct QueryBatch *batch,
+                    enum MapGraphAlgorithm algorithm,
+                    bool distancesOnly,
+                    unsigned int numThreads,
+                    unsigned int cacheSize,
+                    const struct MapLandmarks *landmarks,
+                    const char *outputFilename) {
+    FILE *outputFile;
+    if (strcmp(outputFilename, "stdout") == 0) {
+        outputFile = stdout;
+    } else {
+        outputFile = fopen(outputFilename, "w");
+    }
+    if (numThreads == 0) numThreads = 1;
+    struct QueryTask task;
+    task.graph = graph;
+    task.batch = batch;
+    task.algorithm = algorithm;
+    struct MapHierarchy hierarchy;
+    if (algorithm == MAPGRAPH_HIERARCHICAL) {
+        hierarchy = maphierarchy_create(graph, MAPHIERARCHY_CHUNK_SIZE);
+        task.hierarchy = &hierarchy;
+    } else {
+        task.hierarchy = NULL;
+    }
+    struct MapLandmarks ownLandmarks;
+    task.landmarks = landmarks;
+    if (algorithm == MAPGRAPH_ALT && landmarks == NULL) {
+        ownLandmarks = maplandmarks_create(graph, MAPLANDMARKS_COUNT);
+        task.landmarks = &ownLandmarks;
+    }
+    struct PathCache cache;
+    if (cacheSize > 0) {
+        cache = pathcache_create(cacheSize);
+        task.cache = &cache;
+    } else {
+        task.cache = NULL;
+    }
+    task.paths =
+        (struct MapGraphPath**)malloc(BLOCK_SIZE * sizeof(struct MapGraphPath*));
+    bool sweeps = distancesOnly && algorithm == MAPGRAPH_BFS && cacheSize == 0;
+    task.distances = sweeps ? (int*)malloc(BLOCK_SIZE * sizeof(int)) : NULL;
+    task.order =
+        sweeps ? (unsigned int*)malloc(BLOCK_SIZE * sizeof(unsigned int)) : NULL;
+    task.groups = sweeps ?
+        (unsigned int*)malloc((BLOCK_SIZE + 1) * sizeof(unsigned int)) : NULL;
+    task.block = 0;
+    task.numBusy = 0;
+    task.finished = false;
+    pthread_mutex_init(&task.mutex, NULL);
+    pthread_cond_init(&task.blockStarted, NULL);
+    pthread_cond_init(&task.blockAnswered, NULL);
+    struct QueryWorker *workers =
+        (struct QueryWorker*)malloc(numThreads * sizeof(struct QueryWorker));
+    for (unsigned int t = 0; t < numThreads; ++t) {
+        workers[t].task = &task;
+        if (algorithm == MAPGRAPH_IMPLICIT) {
+            workers[t].grid = mapsearch_createSearch(graph->map);
+        } else {
+            workers[t].search = mapgraph_createSearch(graph);
+        }
+        if (algorithm == MAPGRAPH_BIDIRECTIONAL) {
+            workers[t].backward = mapgraph_createSearch(graph);
+        }
+        if (sweeps) {
+            workers[t].reach = t == 0 ? mapreach_create(graph->map) :
+                mapreach_createShared(&workers[0].reach);
+        }
+    }
+    for (unsigned int t = 1; t < numThreads; ++t) {
+        pthread_create(&workers[t].thread, NULL, querybatch_serve, &workers[t]);
+    }
+    for (unsigned int first = 0; first < batch->numQueries; first += BLOCK_SIZE) {
+        task.first = first;
+        task.next = first;
+        task.last = first + BLOCK_SIZE < batch->numQueries ?
+            first + BLOCK_SIZE : batch->numQueries;
+        if (sweeps) {
+            querybatch_groupBlock(&task);
+            task.next = 0;
+        }
+        pthread_mutex_lock(&task.mutex);
+        ++task.block;
+        task.numBusy = numThreads - 1;
+        pthread_cond_broadcast(&task.blockStarted);
+        pthread_mutex_unlock(&task.mutex);
+        querybatch_work(&workers[0]);
+        pthread_mutex_lock(&task.mutex);
+        while (task.numBusy > 0) {
+            pthread_cond_wait(&task.blockAnswered, &task.mutex);
+        }
+        pthread_mutex_unlock(&task.mutex);
+        for (unsigned int i = 0; i < task.last - task.first; ++i) {
+            if (sweeps) {
+                fprintf(outputFile, "%d\n", task.distances[i]);
+            } else {
+                querybatch_writeAnswer(&task, task.paths[i], distancesOnly,
+                                       outputFile);
+                mapgraph_deletePath(task.paths[i]);
+            }
+        }
+    }
+    pthread_mutex_lock(&task.mutex);
+    task.finished = true;
+    pthread_cond_broadcast(&task.blockStarted);
+    pthread_mutex_unlock(&task.mutex);
+    for (unsigned int t = 1; t < numThreads; ++t) {
+        pthread_join(workers[t].thread, NULL);
+    }
+    for (unsigned int t = numThreads; t > 0; --t) {
+        if (algorithm == MAPGRAPH_IMPLICIT) {
+            mapsearch_deleteSearch(&workers[t - 1].grid);
+        } else {
+            mapgraph_deleteSearch(&workers[t - 1].search);
+        }
+        if (algorithm == MAPGRAPH_BIDIRECTIONAL) {
+            mapgraph_deleteSearch(&workers[t - 1].backward);
+        }
+        if (sweeps) mapreach_delete(&workers[t - 1].reach);
+    }
+    free(workers);
+    pthread_cond_destroy(&task.blockStarted);
+    pthread_cond_destroy(&task.blockAnswered);
+    pthread_mutex_destroy(&task.mutex);
+    free(task.paths);
+    free(task.distances);
+    free(task.order);
+    free(task.groups);
+    if (task.hierarchy != NULL) {
+        maphierarchy_delete(&hierarchy);
+    }
+    if (algorithm == MAPGRAPH_ALT && landmarks == NULL) {
+        maplandmarks_delete(&ownLandmarks);
+    }
+    if (task.cache != NULL) {
+        pathcache_printStatistics(stderr, &cache);
+        pathcache_delete(&cache);
+    }
+    if (strcmp(outputFilename, "stdout") != 0) {
+        fclose(outputFile);
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * Module query_batch
+ *
+ * This module is responsible of answering many shortest path queries on the
+ * same map.
+ *
+ * A batch of queries is loaded from a text file containing one query per
+ * line. Each query is a pair of cells ``L,R,C L,R,C`` (the start cell then the
+ * end cell), where L is the layer, R the row and C the column, separated by
+ * blanks. Empty lines are ignored.
+ *
+ * The graph of the map is built only once and reused for every query. Since
+ * the graph is never modified by a search, the queries can be answered by
+ * several threads at the same time, each thread owning its own search
+ * workspace. The answers are always written in the same order as the
+ * queries, one per line.
+ */
+#ifndef QUERY_BATCH_H
+#define QUERY_BATCH_H
+
+#include <stdbool.h>
+#include "map_graph.h"
+#include "map_landmarks.h"
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct Query {             // A shortest path query
+    struct MapCell start;  // The starting cell
+    struct MapCell end;    // The ending cell
+};
+
+struct QueryBatch {          // A batch of queries
+    struct Query *queries;   // The queries
+    unsigned int numQueries; // The number of queries
+    unsigned int capacity;   // The capacity of the batch
+};
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Loads a batch of queries from a text file.
+ *
+ * If the file cannot be read or if a line is not a valid query, NULL is
+ * returned.
+ *
+ * @param filename  The name of the file containing the queries
+ * @return          The loaded batch
+ */
+struct QueryBatch *querybatch_load(const char *filename);
+
+/**
+ * Deletes the given batch.
+ *
+ * @param batch  The batch to delete
+ */
+void querybatch_delete(struct QueryBatch *batch);
+
+/**
+ * Answers every query of the batch and writes the answers.
+ *
+ * For each query, either the shortest path (in the format of
+ * mapgraph_printPath) or its distance is written on its own line. The
+ * distance is the total cost of the path with Dijkstra's algorithm and its
+ * number of moves with the other algorithms. A
+ * query whose cells are not nodes of the graph, or whose cells are not
+ * connected, is answered by an empty path or by a distance of -1.
+ *
+ * The queries are shared between ``numThreads`` worker threads, which are
+ * started once and answer the blocks of the batch one after the other, each
+ * reusing its own search workspaces from one query to the next. With
+ * hierarchical search, the chunks of the map are preprocessed once for the
+ * whole batch, and so are the landmarks with ALT search if none are given.
+ *
+ * When only the distances of breadth-first searches are wanted and there
+ * is no cache, the queries of a block are grouped by starting cell, and the
+ * groups whose starting cells are shared by several queries are answered by
+ * sweeps from 64 starting cells at once (see the module map_reach).
+ *
+ * If ``cacheSize`` is positive, the answers are kept in a cache of that many
+ * paths (see the module path_cache), so that a query asked again is not
+ * searched again, and the statistics of the cache are written on stderr.
+ *
+ * @param graph           The graph of the map
+ * @param batch           The queries
+ * @param algorithm       The algorithm used to compute the paths
+ * @param distancesOnly   If true, writes the distances instead of the paths
+ * @param numThreads      The number of worker threads (at least 1)
+ * @param cacheSize       The number of cached paths (0 for no cache)
+ * @param landmarks       The landmarks of the graph, for ALT search (NULL to
+ *                        compute them)
+ * @param outputFilename  The name of the output file ("stdout" for stdout)
+ */
+void querybatch_run(const struct MapGraph *graph,
+                    const struct QueryBatch *batch,
+                    enum MapGraphAlgorithm algorithm,
+                    bool distancesOnly,
+                    unsigned int numThreads,
+                    unsigned int cacheSize,
+                    const struct MapLandmarks *landmarks,
+                    const char *outputFilename);
+
+#endif
@@ -1,4 +1,5 @@
 #include "queue.h"
+#include "map_graph.h"
 #include <stdio.h>
 #include <assert.h>
 
@@ -7,10 +8,36 @@ Queue queue_create() {
     queue.first = NULL;
     queue.last = NULL;
     queue.numNodes = 0;
+    queue.buffer = NULL;
+    queue.capacity = 0;
+    queue.head = 0;
+    return queue;
+}
+
+Queue queue_createWithCapacity(unsigned int capacity) {
+    Queue queue = queue_create();
+    queue.buffer = (struct QueueContent*)malloc(
+        (capacity > 0 ? capacity : 1) * sizeof(struct QueueContent));
+    queue.capacity = capacity;
     return queue;
 }
 
 void queue_delete(Queue *queue) {
+    if (queue->buffer != NULL) {
+        free(queue->buffer);
+        queue->buffer = NULL;
+        queue->numNodes = 0;
+    }
+    while (queue->numNodes != 0) {
+        queue_dequeue(queue);
+    }
+}
+
+void queue_clear(Queue *queue) {
+    if (queue->buffer != NULL) {
+        queue->numNodes = 0;
+        queue->head = 0;
+    }
     while (queue->numNodes != 0) {
         queue_dequeue(queue);
     }
@@ -23,6 +50,15 @@ bool queue_isEmpty(const Queue *queue) {
 void queue_enqueue(Queue *queue,
                    struct MapCellNode *cell,
                    unsigned int priority) {
+    if (queue->buffer != NULL) {
+        assert(queue->numNodes < queue->capacity);
+        unsigned int position = queue->head + queue->numNodes;
+        if (position >= queue->capacity) position -= queue->capacity;
+        queue->buffer[position].cell = cell;
+        queue->buffer[position].priority = priority;
+        ++queue->numNodes;
+        return;
+    }
     struct QueueNode *node =
         (struct QueueNode*)malloc(sizeof(struct QueueNode));
     node->content =
@@ -42,6 +78,12 @@ void queue_enqueue(Queue *queue,
 
 struct QueueContent queue_dequeue(Queue *queue) {
     assert(!queue_isEmpty(queue));
+    if (queue->buffer != NULL) {
+        struct QueueContent content = queue->buffer[queue->head];
+        if (++queue->head == queue->capacity) queue->head = 0;
+        --queue->numNodes;
+        return content;
+    }
     struct QueueContent content = *(queue->first->content);
     free(queue->first->content);
     struct QueueNode *node = queue->first;
@@ -56,6 +98,15 @@ struct QueueContent queue_dequeue(Queue *queue) {
 
 void queue_print(const Queue *queue) {
     printf("A queue of %d nodes: [ ", queue->numNodes);
+    for (unsigned int i = 0; queue->buffer != NULL && i < queue->numNodes; ++i) {
+        const struct QueueContent *content =
+            &queue->buffer[(queue->head + i) % queue->capacity];
+        printf("Node(cell = (%d,%d,%d), priority = %d) ",
+               content->cell->cell.row,
+               content->cell->cell.column,
+               content->cell->cell.layer,
+               content->priority);
+    }
     struct QueueNode *node;
     for (node = queue->first; node != NULL; node = node->next) {
         printf("Node(cell = (%d,%d,%d), priority = %d) ",
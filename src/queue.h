@@ -4,6 +4,11 @@
  * This module provides a simple queue (FIFO) data structure and functions
  * operating on it.
  *
+ * A queue is either a doubly linked list, which grows without bound but
+ * allocates memory for each element, or a circular buffer allocated once with
+ * a fixed capacity, in which enqueuing and dequeuing never allocate. Both kinds
+ * of queue are manipulated with the same functions.
+ *
  * @author   Alexandre Blondin Massé
  * @version  1.0
  * @date     June 18th, 2017
@@ -12,7 +17,8 @@
 #define QUEUE_H
 
 #include <stdbool.h>
-#include "map_graph.h"
+
+struct MapCellNode;
 
 // --------------- //
 // Data structures //
@@ -29,10 +35,14 @@ struct QueueNode {                // A node in the queue
     struct QueueNode *next;       // The next node in the queue
 };
 
-typedef struct {             // A simple queue (FIFO)
-    struct QueueNode *first; // The first node in the queue
-    struct QueueNode *last;  // The last node in the queue
-    unsigned int numNodes;   // The number of nodes in the queue
+typedef struct {                 // A simple queue (FIFO)
+    struct QueueNode *first;     // The first node in the queue
+    struct QueueNode *last;      // The last node in the queue
+    unsigned int numNodes;       // The number of nodes in the queue
+    struct QueueContent *buffer; // The circular buffer (NULL if linked)
+    unsigned int capacity;       // The capacity of the circular buffer
+    unsigned int head;           // The position of the first element in the
+                                 // circular buffer
 } Queue;
 
 // --------- //
@@ -46,6 +56,16 @@ typedef struct {             // A simple queue (FIFO)
  */
 Queue queue_create();
 
+/**
+ * Creates an empty queue backed by a circular buffer.
+ *
+ * The queue can contain at most ``capacity`` elements at the same time.
+ *
+ * @param capacity  The maximum number of elements in the queue
+ * @return          The queue
+ */
+Queue queue_createWithCapacity(unsigned int capacity);
+
 /**
  * Destroys the given queue.
  *
@@ -53,6 +73,16 @@ Queue queue_create();
  */
 void queue_delete(Queue *queue);
 
+/**
+ * Removes all the elements of the given queue.
+ *
+ * A queue backed by a circular buffer keeps its buffer, so that it can be
+ * reused without allocating memory.
+ *
+ * @param queue  The queue to be cleared
+ */
+void queue_clear(Queue *queue);
+
 /**
  * Returns true if the given queue is empty.
  *
@@ -0,0 +1,107 @@
+#include "radix_heap.h"
+#include <stdlib.h>
+#include <assert.h>
+
+// ----------------- //
+// Private functions //
+// ----------------- //
+
+/**
+ * Returns the bucket of an element, relatively to the last removed priority.
+ *
+ * The bucket is 0 if both priorities are equal, and otherwise the position
+ * (starting at 1) of the highest bit in which they differ.
+ *
+ * @param last      The priority of the last removed element
+ * @param priority  The priority of the element
+ * @return          The number of the bucket
+ */
+unsigned int radixheap_bucket(unsigned int last, unsigned int priority) {
+    unsigned int bucket = 0;
+    for (unsigned int bits = last ^ priority; bits != 0; bits >>= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+/**
+ * Appends an element to the given bucket.
+ *
+ * @param bucket   The bucket
+ * @param content  The element to append
+ */
+void radixheap_append(struct RadixHeapBucket *bucket,
+                      const struct QueueContent *content) {
+    if (bucket->numNodes == bucket->capacity) {
+        bucket->capacity = bucket->capacity == 0 ? 16 : 2 * bucket->capacity;
+        bucket->contents = realloc(bucket->contents,
+                                   bucket->capacity * sizeof(struct QueueContent));
+    }
+    bucket->contents[bucket->numNodes] = *content;
+    ++bucket->numNodes;
+}
+
+// --------- //
+// Functions //
+// --------- //
+
+RadixHeap radixheap_create() {
+    RadixHeap heap;
+    for (unsigned int i = 0; i < RADIXHEAP_NUM_BUCKETS; ++i) {
+        heap.buckets[i].contents = NULL;
+        heap.buckets[i].numNodes = 0;
+        heap.buckets[i].capacity = 0;
+    }
+    heap.last = 0;
+    heap.numNodes = 0;
+    return heap;
+}
+
+void radixheap_delete(RadixHeap *heap) {
+    for (unsigned int i = 0; i < RADIXHEAP_NUM_BUCKETS; ++i) {
+        free(heap->buckets[i].contents);
+        heap->buckets[i].contents = NULL;
+        heap->buckets[i].numNodes = 0;
+        heap->buckets[i].capacity = 0;
+    }
+    heap->numNodes = 0;
+}
+
+bool radixheap_isEmpty(const RadixHeap *heap) {
+    return heap->numNodes == 0;
+}
+
+void radixheap_push(RadixHeap *heap,
+                    struct MapCellNode *cell,
+                    unsigned int priority) {
+    assert(priority >= heap->last);
+    struct QueueContent content = {cell, priority};
+    radixheap_append(&heap->buckets[radixheap_bucket(heap->last, priority)],
+                     &content);
+    ++heap->numNodes;
+}
+
+struct QueueContent radixheap_pop(RadixHeap *heap) {
+    assert(!radixheap_isEmpty(heap));
+    struct RadixHeapBucket *first = &heap->buckets[0];
+    if (first->numNodes == 0) {
+        unsigned int i = 1;
+        while (heap->buckets[i].numNodes == 0) ++i;
+        struct RadixHeapBucket *bucket = &heap->buckets[i];
+        unsigned int last = bucket->contents[0].priority;
+        for (unsigned int j = 1; j < bucket->numNodes; ++j) {
+            if (bucket->contents[j].priority < last) {
+                last = bucket->contents[j].priority;
+            }
+        }
+        heap->last = last;
+        for (unsigned int j = 0; j < bucket->numNodes; ++j) {
+            unsigned int k = radixheap_bucket(last, bucket->contents[j].priority);
+            radixheap_append(&heap->buckets[k], &bucket->contents[j]);
+        }
+        bucket->numNodes = 0;
+    }
+    --heap->numNodes;
+    --first->numNodes;
+    return first->contents[first->numNodes];
+}
@@ -0,0 +1,93 @@
+/**
+ * Module radix_heap
+ *
+ * This module provides a radix heap, a monotone priority queue data structure,
+ * and functions operating on it.
+ *
+ * A radix heap can only be used when the priorities of the pushed elements
+ * are never smaller than the priority of the last removed element, which is
+ * the case for Dijkstra's algorithm with nonnegative costs. The elements are
+ * dispatched into 33 buckets according to the highest bit in which their
+ * priority differs from the last removed priority. Each element then moves at
+ * most 32 times from one bucket to a lower one, so that pushing and removing
+ * are done in amortized constant time, without comparing the elements.
+ *
+ * The elements of the heap are the same as the elements of a queue, i.e.
+ * nodes of a map graph together with a priority.
+ */
+#ifndef RADIX_HEAP_H
+#define RADIX_HEAP_H
+
+#include <stdbool.h>
+#include "queue.h"
+
+#define RADIXHEAP_NUM_BUCKETS 33 // One bucket per bit, plus the last priority
+
+// --------------- //
+// Data structures //
+// --------------- //
+
+struct RadixHeapBucket {           // A bucket of a radix heap
+    struct QueueContent *contents; // The elements of the bucket
+    unsigned int numNodes;         // The number of elements in the bucket
+    unsigned int capacity;         // The capacity of the bucket
+};
+
+typedef struct {                                           // A radix heap
+    struct RadixHeapBucket buckets[RADIXHEAP_NUM_BUCKETS]; // The buckets
+    unsigned int last;                                     // The priority of
+                                                           // the last removed
+                                                           // element
+    unsigned int numNodes;                                 // The number of
+                                                           // elements
+} RadixHeap;
+
+// --------- //
+// Functions //
+// --------- //
+
+/**
+ * Creates an empty radix heap.
+ *
+ * @return  The radix heap
+ */
+RadixHeap radixheap_create();
+
+/**
+ * Destroys the given radix heap.
+ *
+ * @param heap  The radix heap to be destroyed
+ */
+void radixheap_delete(RadixHeap *heap);
+
+/**
+ * Returns true if the given radix heap is empty.
+ *
+ * @param heap  The radix heap to be checked
+ * @return      True if the radix heap is empty
+ */
+bool radixheap_isEmpty(const RadixHeap *heap);
+
+/**
+ * Inserts a cell in the radix heap with given priority.
+ *
+ * The priority must not be smaller than the priority of the last removed
+ * element.
+ *
+ * @param heap      The radix heap in which the cell is inserted
+ * @param cell      The cell to be inserted
+ * @param priority  The priority to give to the cell
+ */
+void radixheap_push(RadixHeap *heap,
+                    struct MapCellNode *cell,
+                    unsigned int priority);
+
+/**
+ * Removes an element of smallest priority in the radix heap and returns it.
+ *
+ * @param heap  The radix heap from which the element is removed
+ * @return      An element of smallest priority
+ */
+struct QueueContent radixheap_pop(RadixHeap *heap);
+
+#endif
@@ -13,30 +13,29 @@ int main() {
     map_addTile(map, "ne", "art/ne.png");
     map_addTile(map, "ne", "art/sw.png");
     map_printMap(map, false);
-    struct Layer *layer;
     // Layer 1
-    layer = map_addLayer(map, 0, 0);
+    map_addLayer(map, 0, 0);
     for (unsigned int i = 0; i < r; ++i) {
         for (unsigned int j = 0; j < c; ++j) {
-            layer->tiles[i][j] = 1;
+            map_setTile(map, 0, i, j, 1);
         }
     }
     // Layer 2
-    layer = map_addLayer(map, 0, yoffset);
-    layer->tiles[0][0] = 2;
-    layer->tiles[r - 1][c - 1] = 3;
-    layer->tiles[2][1] = 4;
-    layer->tiles[1][1] = 1;
-    layer->tiles[6][2] = 1;
-    layer->tiles[4][5] = 1;
-    layer->tiles[5][6] = 1;
-    layer->tiles[4][6] = 1;
+    map_addLayer(map, 0, yoffset);
+    map_setTile(map, 1, 0, 0, 2);
+    map_setTile(map, 1, r - 1, c - 1, 3);
+    map_setTile(map, 1, 2, 1, 4);
+    map_setTile(map, 1, 1, 1, 1);
+    map_setTile(map, 1, 6, 2, 1);
+    map_setTile(map, 1, 4, 5, 1);
+    map_setTile(map, 1, 5, 6, 1);
+    map_setTile(map, 1, 4, 6, 1);
     // Layer 3
-    layer = map_addLayer(map, 0, 2 * yoffset);
-    layer->tiles[4][5] = 4;
-    layer->tiles[6][2] = 1;
-    layer->tiles[5][6] = 4;
-    layer->tiles[4][6] = 5;
+    map_addLayer(map, 0, 2 * yoffset);
+    map_setTile(map, 2, 4, 5, 4);
+    map_setTile(map, 2, 6, 2, 1);
+    map_setTile(map, 2, 5, 6, 4);
+    map_setTile(map, 2, 4, 6, 5);
 
     map_printMap(map, false);
     map_toPNG(map, "map.png");
@@ -3,6 +3,7 @@
 #include "map_graph.h"
 #include "map_loader.h"
 #include "queue.h"
+#include "radix_heap.h"
 #include "CUnit/Basic.h"
 
 // Global variables
@@ -72,6 +73,52 @@ void test_data() {
     queue_delete(&queue);
 }
 
+void test_circularBuffer() {
+    Queue queue = queue_createWithCapacity(2);
+    struct QueueContent content;
+    CU_ASSERT(queue_isEmpty(&queue));
+    queue_enqueue(&queue, &graph.nodes[0], 0);
+    queue_enqueue(&queue, &graph.nodes[1], 1);
+    CU_ASSERT(queue.numNodes == 2);
+    content = queue_dequeue(&queue);
+    CU_ASSERT(content.cell == &graph.nodes[0]);
+    CU_ASSERT(content.priority == 0);
+    queue_enqueue(&queue, &graph.nodes[2], 2);
+    CU_ASSERT(queue.numNodes == 2);
+    content = queue_dequeue(&queue);
+    CU_ASSERT(content.cell == &graph.nodes[1]);
+    content = queue_dequeue(&queue);
+    CU_ASSERT(content.cell == &graph.nodes[2]);
+    CU_ASSERT(content.priority == 2);
+    CU_ASSERT(queue_isEmpty(&queue));
+    queue_delete(&queue);
+}
+
+void test_radixHeap() {
+    struct MapCellNode nodes[100];
+    RadixHeap heap = radixheap_create();
+    unsigned int last = 0, numPopped = 0;
+    CU_ASSERT(radixheap_isEmpty(&heap));
+    for (unsigned int i = 0; i < 100; ++i) {
+        radixheap_push(&heap, &nodes[i], last + (i * 37) % 101);
+        if (i % 3 == 2) {
+            struct QueueContent content = radixheap_pop(&heap);
+            CU_ASSERT(content.priority >= last);
+            last = content.priority;
+            ++numPopped;
+        }
+    }
+    while (!radixheap_isEmpty(&heap)) {
+        struct QueueContent content = radixheap_pop(&heap);
+        CU_ASSERT(content.priority >= last);
+        CU_ASSERT(content.cell >= &nodes[0] && content.cell < &nodes[100]);
+        last = content.priority;
+        ++numPopped;
+    }
+    CU_ASSERT(numPopped == 100);
+    radixheap_delete(&heap);
+}
+
 int main() {
     CU_pSuite pSuite = NULL;
     if (CU_initialize_registry() != CUE_SUCCESS )
@@ -94,6 +141,14 @@ int main() {
         CU_cleanup_registry();
         return CU_get_error();
     }
+    if (CU_add_test(pSuite, "Testing circular buffer", test_circularBuffer) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing radix heap", test_radixHeap) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
 
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
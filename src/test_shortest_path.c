@@ -0,0 +1,884 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "map.h"
+#include "map_graph.h"
+#include "map_hierarchy.h"
+#include "path_cache.h"
+#include "flow_field.h"
+#include "map_landmarks.h"
+#include "map_search.h"
+#include "map_reach.h"
+#include "CUnit/Basic.h"
+
+#define NUM_ROWS 24
+#define NUM_COLUMNS 24
+
+// Global variables
+struct Map *map;
+struct MapGraph graph;
+
+/**
+ * Adds all the directions of a flat tile, i.e. the four horizontal moves and
+ * the four moves climbing on the layer above.
+ */
+void addFlatDirections(struct Tile *tile) {
+    int deltas[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    for (unsigned int i = 0; i < 4; ++i) {
+        struct Direction horizontal = {deltas[i][0], deltas[i][1], 0};
+        struct Direction upward = {deltas[i][0], deltas[i][1], 1};
+        map_addDirection(tile, &horizontal);
+        map_addDirection(tile, &upward);
+    }
+}
+
+int initSuite() {
+    map = map_createMap(NUM_ROWS, NUM_COLUMNS, 3, 3);
+    struct Tile *flat = map_addTile(map, "flat", "art/flat.png");
+    struct Tile *ramp = map_addTile(map, "ne", "art/ne.png");
+    struct Direction down = {1, 0, -1}, up = {-1, 0, 0};
+    addFlatDirections(flat);
+    map_addDirection(ramp, &down);
+    map_addDirection(ramp, &up);
+    srand(2017);
+    for (unsigned int k = 0; k < 3; ++k) {
+        map_addLayer(map, 0, -78 * (int)k);
+        for (unsigned int i = 0; i < NUM_ROWS; ++i) {
+            for (unsigned int j = 0; j < NUM_COLUMNS; ++j) {
+                int r = rand() % 100;
+                if (k == 0 && r < 85) {
+                    map_setTile(map, k, i, j, 1);
+                } else if (k > 0 && r < 12 / (int)k) {
+                    map_setTile(map, k, i, j, r % 3 == 0 ? 2 : 1);
+                }
+            }
+        }
+    }
+    graph = mapgraph_create(map);
+    return 0;
+}
+
+int cleanSuite() {
+    mapgraph_delete(&graph);
+    map_deleteMap(map);
+    return 0;
+}
+
+/**
+ * Returns the index of the node of the given cell, or MAPGRAPH_NO_NODE.
+ */
+unsigned int nodeIndex(const struct MapCell *cell) {
+    return graph.nodeIndex[(cell->layer * NUM_ROWS + cell->row) * NUM_COLUMNS
+                           + cell->column];
+}
+
+/**
+ * Returns true if the path goes from start to end by moving along edges.
+ */
+bool isValidPath(const struct MapGraphPath *path,
+                 const struct MapCell *start,
+                 const struct MapCell *end) {
+    if (nodeIndex(&path->cells[0]) != nodeIndex(start)) return false;
+    for (unsigned int i = 0; i + 1 < path->numCells; ++i) {
+        unsigned int index = nodeIndex(&path->cells[i]);
+        unsigned int next = nodeIndex(&path->cells[i + 1]);
+        bool found = false;
+        for (unsigned int j = 0; j < mapgraph_numNeighbors(&graph, index); ++j) {
+            if (mapgraph_getNeighbor(&graph, index, j) == next) found = true;
+        }
+        if (!found) return false;
+    }
+    return nodeIndex(&path->cells[path->numCells - 1]) == nodeIndex(end);
+}
+
+/**
+ * Checks that the given algorithm agrees with the BFS on many queries.
+ */
+void checkAgainstBFS(enum MapGraphAlgorithm algorithm) {
+    unsigned int numPaths = 0;
+    for (unsigned int i = 0; i < graph.numNodes; i += 7) {
+        for (unsigned int j = 0; j < graph.numNodes; j += 11) {
+            const struct MapCell *start = &graph.nodes[i].cell;
+            const struct MapCell *end = &graph.nodes[j].cell;
+            struct MapGraphPath *expected =
+                mapgraph_shortestPath(&graph, start, end);
+            struct MapGraphPath *path = algorithm == MAPGRAPH_IMPLICIT ?
+                mapsearch_shortestPath(map, start, end) :
+                mapgraph_shortestPathWith(&graph, start, end, algorithm);
+            CU_ASSERT(mapgraph_pathLength(path) == mapgraph_pathLength(expected));
+            if (path != NULL) {
+                CU_ASSERT(isValidPath(path, start, end));
+                ++numPaths;
+            }
+            mapgraph_deletePath(expected);
+            mapgraph_deletePath(path);
+        }
+    }
+    CU_ASSERT(numPaths > 0);
+}
+
+void test_astar() {
+    checkAgainstBFS(MAPGRAPH_ASTAR);
+}
+
+void test_bidirectional() {
+    checkAgainstBFS(MAPGRAPH_BIDIRECTIONAL);
+}
+
+void test_implicit() {
+    checkAgainstBFS(MAPGRAPH_IMPLICIT);
+}
+
+void test_dijkstra() {
+    checkAgainstBFS(MAPGRAPH_DIJKSTRA);
+}
+
+/**
+ * Returns the cost of a cheapest path between two nodes, computed by
+ * relaxing every edge until no cost decreases.
+ */
+int cheapestCost(unsigned int start, unsigned int end) {
+    unsigned int *cost =
+        (unsigned int*)malloc(graph.numNodes * sizeof(unsigned int));
+    for (unsigned int i = 0; i < graph.numNodes; ++i) cost[i] = (unsigned int)-1;
+    cost[start] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (unsigned int i = 0; i < graph.numNodes; ++i) {
+            if (cost[i] == (unsigned int)-1) continue;
+            for (unsigned int j = 0; j < mapgraph_numNeighbors(&graph, i); ++j) {
+                unsigned int k = mapgraph_getNeighbor(&graph, i, j);
+                if (cost[i] + graph.nodes[k].tile->cost < cost[k]) {
+                    cost[k] = cost[i] + graph.nodes[k].tile->cost;
+                    changed = true;
+                }
+            }
+        }
+    }
+    int result = cost[end] == (unsigned int)-1 ? -1 : (int)cost[end];
+    free(cost);
+    return result;
+}
+
+void test_weightedDijkstra() {
+    struct Tile mud = map->tiles[1];
+    struct Tile **tiles =
+        (struct Tile**)malloc(graph.numNodes * sizeof(struct Tile*));
+    mud.cost = 4;
+    for (unsigned int i = 0; i < graph.numNodes; ++i) {
+        tiles[i] = graph.nodes[i].tile;
+        if (i % 5 == 0 && tiles[i] == &map->tiles[1]) graph.nodes[i].tile = &mud;
+    }
+    map->tiles[2].cost = 5;
+    for (unsigned int i = 0; i < graph.numNodes; i += 97) {
+        for (unsigned int j = 0; j < graph.numNodes; j += 89) {
+            const struct MapCell *start = &graph.nodes[i].cell;
+            const struct MapCell *end = &graph.nodes[j].cell;
+            struct MapGraphPath *path =
+                mapgraph_shortestPathDijkstra(&graph, start, end);
+            CU_ASSERT(mapgraph_pathCost(&graph, path) == cheapestCost(i, j));
+            if (path != NULL) CU_ASSERT(isValidPath(path, start, end));
+            mapgraph_deletePath(path);
+        }
+    }
+    map->tiles[2].cost = 1;
+    for (unsigned int i = 0; i < graph.numNodes; ++i) {
+        graph.nodes[i].tile = tiles[i];
+    }
+    free(tiles);
+}
+
+void test_compactBidirectional() {
+    mapgraph_compact(&graph);
+    checkAgainstBFS(MAPGRAPH_BIDIRECTIONAL);
+}
+
+void test_searchWorkspace() {
+    struct MapGraphSearch search = mapgraph_createSearch(&graph);
+    search.generation = (unsigned int)-3;
+    for (unsigned int i = 0; i < graph.numNodes; i += 13) {
+        for (unsigned int j = 0; j < graph.numNodes; j += 17) {
+            const struct MapCell *start = &graph.nodes[i].cell;
+            const struct MapCell *end = &graph.nodes[j].cell;
+            struct MapGraphPath *expected =
+                mapgraph_shortestPathAStar(&graph, start, end);
+            struct MapGraphPath *path =
+                mapgraph_searchShortestPath(&search, start, end);
+            CU_ASSERT(mapgraph_pathLength(path) == mapgraph_pathLength(expected));
+            if (path != NULL) CU_ASSERT(isValidPath(path, start, end));
+            mapgraph_deletePath(expected);
+            mapgraph_deletePath(path);
+        }
+    }
+    CU_ASSERT(search.generation < (unsigned int)-3);
+    mapgraph_deleteSearch(&search);
+}
+
+void test_components() {
+    bool connected[64][64];
+    for (unsigned int i = 0; i < 64; ++i) {
+        for (unsigned int j = 0; j < 64; ++j) {
+            struct MapGraphPath *path =
+                mapgraph_shortestPath(&graph, &graph.nodes[i * 8].cell,
+                                      &graph.nodes[j * 8].cell);
+            connected[i][j] = path != NULL;
+            mapgraph_deletePath(path);
+        }
+    }
+    mapgraph_labelComponents(&graph);
+    CU_ASSERT(graph.numComponents > 1);
+    for (unsigned int i = 0; i < 64; ++i) {
+        for (unsigned int j = 0; j < 64; ++j) {
+            const struct MapCell *start = &graph.nodes[i * 8].cell;
+            const struct MapCell *end = &graph.nodes[j * 8].cell;
+            struct MapGraphPath *path =
+                mapgraph_shortestPathBidirectional(&graph, start, end);
+            CU_ASSERT(mapgraph_areConnected(&graph, start, end) == connected[i][j]);
+            CU_ASSERT((path != NULL) == connected[i][j]);
+            mapgraph_deletePath(path);
+        }
+    }
+}
+
+/**
+ * Checks that the hierarchy agrees with the BFS on the graph of the hierarchy.
+ */
+void checkHierarchy(const struct MapHierarchy *hierarchy, bool checkPaths) {
+    const struct MapGraph *hierarchyGraph = hierarchy->graph;
+    struct MapGraphSearch search = mapgraph_createSearch(hierarchyGraph);
+    for (unsigned int i = 0; i < hierarchyGraph->numNodes; i += 7) {
+        for (unsigned int j = 0; j < hierarchyGraph->numNodes; j += 11) {
+            const struct MapCell *start = &hierarchyGraph->nodes[i].cell;
+            const struct MapCell *end = &hierarchyGraph->nodes[j].cell;
+            struct MapGraphPath *expected =
+                mapgraph_shortestPath(hierarchyGraph, start, end);
+            struct MapGraphPath *path =
+                maphierarchy_shortestPath(hierarchy, &search, start, end);
+            CU_ASSERT(mapgraph_pathLength(path) == mapgraph_pathLength(expected));
+            if (checkPaths && path != NULL) {
+                CU_ASSERT(isValidPath(path, start, end));
+            }
+            mapgraph_deletePath(expected);
+            mapgraph_deletePath(path);
+        }
+    }
+    mapgraph_deleteSearch(&search);
+}
+
+void test_hierarchical() {
+    struct MapHierarchy hierarchy = maphierarchy_create(&graph, 5);
+    CU_ASSERT(hierarchy.numChunkRows == 5);
+    CU_ASSERT(hierarchy.numEntrances > 0);
+    checkHierarchy(&hierarchy, true);
+    maphierarchy_delete(&hierarchy);
+}
+
+void test_hierarchyUpdate() {
+    struct MapGraph oldGraph = mapgraph_create(map);
+    struct MapHierarchy hierarchy = maphierarchy_create(&oldGraph, 5);
+    unsigned int cells[4][2] = {{4, 5}, {9, 9}, {12, 13}, {23, 0}};
+    for (unsigned int c = 0; c < 4; ++c) {
+        unsigned int row = cells[c][0], column = cells[c][1];
+        unsigned int tileID = map_getTile(map, 1, row, column) == 0 ? 1 : 0;
+        map_setTile(map, 1, row, column, tileID);
+        struct MapGraph newGraph = mapgraph_create(map);
+        maphierarchy_update(&hierarchy, &newGraph, row, column);
+        checkHierarchy(&hierarchy, false);
+        mapgraph_delete(&oldGraph);
+        oldGraph = newGraph;
+    }
+    maphierarchy_delete(&hierarchy);
+    mapgraph_delete(&oldGraph);
+}
+
+void test_samePath() {
+    struct MapGraphPath *path =
+        mapgraph_shortestPathBidirectional(&graph, &graph.nodes[0].cell,
+                                           &graph.nodes[0].cell);
+    CU_ASSERT(mapgraph_pathLength(path) == 0);
+    mapgraph_deletePath(path);
+}
+
+void test_pathCache() {
+    struct PathCache cache = pathcache_create(2);
+    const struct MapCell *cells[4];
+    for (unsigned int i = 0; i < 4; ++i) {
+        cells[i] = &graph.nodes[i * (graph.numNodes / 4)].cell;
+    }
+    struct MapGraphPath *expected =
+        mapgraph_shortestPath(&graph, cells[0], cells[1]);
+    struct MapGraphPath *first =
+        pathcache_shortestPath(&cache, &graph, cells[0], cells[1]);
+    struct MapGraphPath *second =
+        pathcache_shortestPath(&cache, &graph, cells[0], cells[1]);
+    struct PathCacheStatistics statistics = pathcache_statistics(&cache);
+    CU_ASSERT(statistics.numHits == 1 && statistics.numMisses == 1);
+    CU_ASSERT(first != second);
+    CU_ASSERT(mapgraph_pathLength(first) == mapgraph_pathLength(expected));
+    CU_ASSERT(mapgraph_pathLength(second) == mapgraph_pathLength(expected));
+    mapgraph_deletePath(expected);
+    mapgraph_deletePath(first);
+    mapgraph_deletePath(second);
+
+    // The least recently used path is discarded
+    for (unsigned int i = 2; i < 4; ++i) {
+        mapgraph_deletePath(pathcache_shortestPath(&cache, &graph,
+                                                   cells[0], cells[i]));
+    }
+    struct MapGraphPath *path;
+    CU_ASSERT(pathcache_statistics(&cache).numEntries == 2);
+    CU_ASSERT(!pathcache_lookup(&cache, graph.version,
+                                cells[0], cells[1], &path));
+    CU_ASSERT(pathcache_lookup(&cache, graph.version,
+                               cells[0], cells[3], &path));
+    mapgraph_deletePath(path);
+
+    // A path of an older version of the map is outdated
+    CU_ASSERT(!pathcache_lookup(&cache, graph.version + 1,
+                                cells[0], cells[3], &path));
+    pathcache_insert(&cache, graph.version + 1, cells[0], cells[3], NULL);
+    CU_ASSERT(pathcache_lookup(&cache, graph.version + 1,
+                               cells[0], cells[3], &path));
+    CU_ASSERT(path == NULL);
+    statistics = pathcache_statistics(&cache);
+    CU_ASSERT(statistics.numEntries == 2);
+    CU_ASSERT(statistics.numHits == 3 && statistics.numMisses == 5);
+    pathcache_delete(&cache);
+
+    // A large cache is split into shards that keep all of its paths
+    cache = pathcache_create(1024);
+    CU_ASSERT(cache.numShards > 1);
+    for (unsigned int i = 0; i < 32; ++i) {
+        pathcache_insert(&cache, graph.version,
+                         cells[0], &graph.nodes[i].cell, NULL);
+    }
+    for (unsigned int i = 0; i < 32; ++i) {
+        CU_ASSERT(pathcache_lookup(&cache, graph.version,
+                                   cells[0], &graph.nodes[i].cell, &path));
+    }
+    statistics = pathcache_statistics(&cache);
+    CU_ASSERT(statistics.numEntries == 32 && statistics.numHits == 32);
+    pathcache_delete(&cache);
+}
+
+void test_flowField() {
+    struct MapGraphSearch search = mapgraph_createSearch(&graph);
+    for (unsigned int g = 0; g < graph.numNodes; g += 97) {
+        const struct MapCell *goal = &graph.nodes[g].cell;
+        struct FlowField field = flowfield_create(&search, goal);
+        CU_ASSERT(flowfield_distance(&field, goal) == 0);
+        for (unsigned int i = 0; i < graph.numNodes; i += 5) {
+            const struct MapCell *start = &graph.nodes[i].cell;
+            struct MapGraphPath *expected =
+                mapgraph_shortestPath(&graph, start, goal);
+            struct MapGraphPath *path = flowfield_path(&field, start);
+            CU_ASSERT(mapgraph_pathLength(path) == mapgraph_pathLength(expected));
+            if (path != NULL) {
+                CU_ASSERT(isValidPath(path, start, goal));
+            } else {
+                CU_ASSERT(flowfield_distance(&field, start)
+                          == FLOWFIELD_UNREACHABLE);
+            }
+            mapgraph_deletePath(expected);
+            mapgraph_deletePath(path);
+        }
+        flowfield_delete(&field);
+    }
+    mapgraph_deleteSearch(&search);
+}
+
+/**
+ * Returns the distance from a cell to the closest ramp tile, or -1.
+ */
+int rampDistance(struct MapGraphSearch *search, const struct MapCell *start) {
+    int best = -1;
+    mapgraph_searchFrom(search, start);
+    for (unsigned int i = 0; i < graph.numNodes; ++i) {
+        if (search->generations[i] == search->generation &&
+            strcmp(graph.nodes[i].tile->name, "ne") == 0 &&
+            (best == -1 || search->distance[i] < best)) {
+            best = search->distance[i];
+        }
+    }
+    return best;
+}
+
+void test_nearest() {
+    struct MapGraphSearch search = mapgraph_createSearch(&graph);
+    struct MapGraphSearch sources = mapgraph_createSearch(&graph);
+    mapgraph_searchFromTiles(&sources, "ne");
+    unsigned int numPaths = 0;
+    for (unsigned int i = 0; i < graph.numNodes; i += 3) {
+        const struct MapCell *start = &graph.nodes[i].cell;
+        int expected = rampDistance(&search, start);
+        struct MapGraphPath *nearest =
+            mapgraph_searchNearest(&search, start, "ne");
+        struct MapGraphPath *toSource = mapgraph_pathToSource(&sources, start);
+        CU_ASSERT(mapgraph_pathLength(nearest) == expected);
+        CU_ASSERT(mapgraph_pathLength(toSource) == expected);
+        if (nearest != NULL) {
+            const struct MapCell *last = &nearest->cells[nearest->numCells - 1];
+            const struct MapCell *source = &toSource->cells[toSource->numCells - 1];
+            CU_ASSERT(isValidPath(nearest, start, last));
+            CU_ASSERT(isValidPath(toSource, start, source));
+            CU_ASSERT(strcmp(graph.nodes[nodeIndex(last)].tile->name, "ne") == 0);
+            CU_ASSERT(strcmp(graph.nodes[nodeIndex(source)].tile->name, "ne") == 0);
+            ++numPaths;
+        }
+        mapgraph_deletePath(nearest);
+        mapgraph_deletePath(toSource);
+    }
+    CU_ASSERT(numPaths > 0);
+    CU_ASSERT(mapgraph_searchNearest(&search, &graph.nodes[0].cell, "lava") == NULL);
+    mapgraph_deleteSearch(&search);
+    mapgraph_deleteSearch(&sources);
+}
+
+void test_range() {
+    struct MapGraphSearch search = mapgraph_createSearch(&graph);
+    struct MapGraphSearch full = mapgraph_createSearch(&graph);
+    unsigned int maxMoves[4] = {0, 1, 3, 7};
+    for (unsigned int i = 0; i < graph.numNodes; i += 31) {
+        mapgraph_searchFrom(&full, &graph.nodes[i].cell);
+        for (unsigned int m = 0; m < 4; ++m) {
+            struct MapGraphRange *range =
+                mapgraph_searchWithin(&search, &graph.nodes[i].cell, maxMoves[m]);
+            unsigned int expected = 0;
+            for (unsigned int j = 0; j < graph.numNodes; ++j) {
+                if (full.generations[j] == full.generation &&
+                    full.distance[j] <= (int)maxMoves[m]) {
+                    ++expected;
+                }
+            }
+            CU_ASSERT(range->numCells == expected);
+            int previous = 0;
+            for (unsigned int c = 0; c < range->numCells; ++c) {
+                int distance = full.distance[nodeIndex(&range->cells[c])];
+                CU_ASSERT(distance >= previous && distance <= (int)maxMoves[m]);
+                previous = distance;
+            }
+            mapgraph_deleteRange(range);
+        }
+    }
+    mapgraph_deleteSearch(&search);
+    mapgraph_deleteSearch(&full);
+}
+
+void test_landmarks() {
+    struct MapLandmarks landmarks = maplandmarks_create(&graph, MAPLANDMARKS_COUNT);
+    CU_ASSERT(landmarks.numLandmarks == MAPLANDMARKS_COUNT);
+    struct MapGraphSearch search = mapgraph_createSearch(&graph);
+    for (unsigned int i = 0; i < graph.numNodes; i += 13) {
+        mapgraph_searchFrom(&search, &graph.nodes[i].cell);
+        for (unsigned int j = 0; j < graph.numNodes; ++j) {
+            if (search.generations[j] == search.generation) {
+                CU_ASSERT(maplandmarks_estimate(&landmarks, j, i)
+                          <= (unsigned int)search.distance[j]);
+            }
+        }
+    }
+
+    // The paths are as short as those of the BFS, query after query
+    unsigned int numPaths = 0;
+    for (unsigned int i = 0; i < graph.numNodes; i += 7) {
+        for (unsigned int j = 0; j < graph.numNodes; j += 11) {
+            const struct MapCell *start = &graph.nodes[i].cell;
+            const struct MapCell *end = &graph.nodes[j].cell;
+            struct MapGraphPath *expected =
+                mapgraph_shortestPath(&graph, start, end);
+            struct MapGraphPath *path =
+                maplandmarks_shortestPath(&landmarks, &search, start, end);
+            CU_ASSERT(mapgraph_pathLength(path) ==
+                      mapgraph_pathLength(expected));
+            if (path != NULL) {
+                CU_ASSERT(isValidPath(path, start, end));
+                ++numPaths;
+            }
+            mapgraph_deletePath(path);
+            mapgraph_deletePath(expected);
+        }
+    }
+    CU_ASSERT(numPaths > 0);
+    mapgraph_deleteSearch(&search);
+
+    // The tables are saved and loaded only for the same graph
+    const char *filename = "test_landmarks.lmk";
+    struct MapLandmarks loaded;
+    CU_ASSERT(maplandmarks_save(&landmarks, filename));
+    CU_ASSERT(maplandmarks_load(&loaded, &graph, filename));
+    CU_ASSERT(loaded.numLandmarks == landmarks.numLandmarks);
+    CU_ASSERT(memcmp(loaded.distances, landmarks.distances,
+                     graph.numNodes * landmarks.numLandmarks
+                     * sizeof(uint32_t)) == 0);
+    maplandmarks_delete(&loaded);
+    const struct MapCell *cell = &graph.nodes[5].cell;
+    unsigned int tileID = map_getTile(map, cell->layer, cell->row, cell->column);
+    map_setTile(map, cell->layer, cell->row, cell->column, 0);
+    struct MapGraph edited = mapgraph_create(map);
+    mapgraph_compact(&edited);
+    CU_ASSERT(!maplandmarks_load(&loaded, &edited, filename));
+    mapgraph_delete(&edited);
+    map_setTile(map, cell->layer, cell->row, cell->column, tileID);
+
+    // A header announcing too many landmarks is rejected before reading
+    FILE *forged = fopen(filename, "wb");
+    uint32_t header[3] = {landmarks.checksum, graph.numNodes,
+                          MAPLANDMARKS_MAX + 1};
+    unsigned char bytes[12];
+    for (unsigned int i = 0; i < 12; ++i) {
+        bytes[i] = (header[i / 4] >> (8 * (i % 4))) & 0xff;
+    }
+    fwrite("LMKS", 1, 4, forged);
+    fwrite(bytes, 1, 12, forged);
+    fclose(forged);
+    CU_ASSERT(!maplandmarks_load(&loaded, &graph, filename));
+    remove(filename);
+    maplandmarks_delete(&landmarks);
+}
+
+void test_landmarksUnreachable() {
+    struct Map *lineMap = map_createMap(1, 5, 1, 2);
+    addFlatDirections(map_addTile(lineMap, "flat", "art/flat.png"));
+    map_addLayer(lineMap, 0, 0);
+    for (unsigned int j = 0; j < 5; ++j) {
+        if (j != 3) map_setTile(lineMap, 0, 0, j, 1);
+    }
+    struct MapGraph lineGraph = mapgraph_create(lineMap);
+    CU_ASSERT(lineGraph.numComponents == 0);
+    struct MapLandmarks landmarks = maplandmarks_create(&lineGraph, 2);
+    struct MapGraphSearch search = mapgraph_createSearch(&lineGraph);
+    struct MapCell cells[5];
+    for (unsigned int j = 0; j < 5; ++j) {
+        struct MapCell cell = {0, j, 0};
+        cells[j] = cell;
+    }
+
+    // The isolated cell is never reached, even though the previous searches
+    // left predecessors in the workspace
+    unsigned int queries[4][2] = {{0, 2}, {1, 2}, {4, 2}, {2, 4}};
+    int lengths[4] = {2, 1, -1, -1};
+    for (unsigned int q = 0; q < 4; ++q) {
+        struct MapGraphPath *path =
+            maplandmarks_shortestPath(&landmarks, &search,
+                                      &cells[queries[q][0]],
+                                      &cells[queries[q][1]]);
+        CU_ASSERT(mapgraph_pathLength(path) == lengths[q]);
+        mapgraph_deletePath(path);
+        path = mapgraph_searchShortestPathAStar(&search,
+                                                &cells[queries[q][0]],
+                                                &cells[queries[q][1]]);
+        CU_ASSERT(mapgraph_pathLength(path) == lengths[q]);
+        mapgraph_deletePath(path);
+    }
+    mapgraph_deleteSearch(&search);
+    maplandmarks_delete(&landmarks);
+    mapgraph_delete(&lineGraph);
+    map_deleteMap(lineMap);
+}
+
+void test_reach() {
+    struct MapReach reach = mapreach_create(map);
+    struct MapGraphSearch search = mapgraph_createSearch(&graph);
+    struct MapCell sources[MAPREACH_MAX_SOURCES];
+    unsigned int numSources = 0;
+    for (unsigned int i = 0; i < graph.numNodes &&
+         numSources < MAPREACH_MAX_SOURCES - 1; i += 7) {
+        sources[numSources++] = graph.nodes[i].cell;
+    }
+    struct MapCell outside = {0, 0, map->numLayers};
+    sources[numSources++] = outside;
+
+    // Without targets, every reachable cell is swept
+    mapreach_search(&reach, sources, numSources, NULL, NULL, 0, NULL);
+    for (unsigned int s = 0; s < numSources - 1; ++s) {
+        mapgraph_searchFrom(&search, &sources[s]);
+        for (unsigned int j = 0; j < graph.numNodes; ++j) {
+            CU_ASSERT(mapreach_isReachable(&reach, s, &graph.nodes[j].cell) ==
+                      (search.generations[j] == search.generation));
+        }
+    }
+    CU_ASSERT(mapreach_sources(&reach, &outside) == 0);
+
+    // Each target gets the distance from its own starting cell
+    unsigned int numTargets = 0;
+    struct MapCell *targets = (struct MapCell*)malloc(
+        numSources * graph.numNodes * sizeof(struct MapCell));
+    unsigned int *targetSources = (unsigned int*)malloc(
+        numSources * graph.numNodes * sizeof(unsigned int));
+    for (unsigned int s = 0; s < numSources; ++s) {
+        for (unsigned int j = s % 5; j < graph.numNodes; j += 5) {
+            targets[numTargets] = graph.nodes[j].cell;
+            targetSources[numTargets++] = s;
+        }
+    }
+    targets[numTargets] = outside;
+    targetSources[numTargets++] = 0;
+    int *distances = (int*)malloc(numTargets * sizeof(int));
+    mapreach_search(&reach, sources, numSources,
+                    targets, targetSources, numTargets, distances);
+    for (unsigned int t = 0; t < numTargets; ++t) {
+        const struct MapCell *source = &sources[targetSources[t]];
+        if (!mapgraph_hasCell(&graph, source) ||
+            !mapgraph_hasCell(&graph, &targets[t])) {
+            CU_ASSERT(distances[t] == -1);
+            continue;
+        }
+        struct MapGraphPath *path =
+            mapgraph_shortestPath(&graph, source, &targets[t]);
+        CU_ASSERT(distances[t] == mapgraph_pathLength(path));
+        mapgraph_deletePath(path);
+    }
+
+    // A shared workspace gives the same sweep, and a new sweep forgets the
+    // cells reached by the previous one
+    struct MapReach shared = mapreach_createShared(&reach);
+    mapreach_search(&reach, &sources[1], 1, NULL, NULL, 0, NULL);
+    mapreach_search(&shared, &sources[1], 1, NULL, NULL, 0, NULL);
+    mapgraph_searchFrom(&search, &sources[1]);
+    for (unsigned int j = 0; j < graph.numNodes; ++j) {
+        const struct MapCell *cell = &graph.nodes[j].cell;
+        CU_ASSERT(mapreach_sources(&reach, cell) ==
+                  (search.generations[j] == search.generation ? 1u : 0u));
+        CU_ASSERT(mapreach_sources(&shared, cell) ==
+                  mapreach_sources(&reach, cell));
+    }
+    mapreach_delete(&shared);
+    free(targets);
+    free(targetSources);
+    free(distances);
+    mapgraph_deleteSearch(&search);
+    mapreach_delete(&reach);
+}
+
+void test_tileStorage() {
+    CU_ASSERT(!map->layers[0].wideTileIDs);
+    struct Map *wideMap = map_createMap(3, 70, 2, 300);
+    for (unsigned int t = 1; t < 300; ++t) {
+        map_addTile(wideMap, "flat", "art/flat.png");
+    }
+    map_addLayer(wideMap, 0, 0);
+    map_addLayer(wideMap, 0, -78);
+    CU_ASSERT(map_addLayer(wideMap, 0, -156) == NULL);
+    CU_ASSERT(wideMap->layers[1].wideTileIDs);
+    map_setTile(wideMap, 1, 2, 69, 299);
+    map_setTile(wideMap, 1, 0, 0, 256);
+    map_setTile(wideMap, 0, 1, 64, 3);
+    struct MapGraphPath *path = mapgraph_createPath(2);
+    struct MapCell first = {2, 69, 1}, second = {1, 64, 0};
+    path->cells[0] = first;
+    path->cells[1] = second;
+    map_addSolution(wideMap, path);
+    for (unsigned int k = 0; k < 2; ++k) {
+        for (unsigned int i = 0; i < 3; ++i) {
+            for (unsigned int j = 0; j < 70; ++j) {
+                unsigned int expected =
+                    k == 1 && i == 2 && j == 69 ? 299 :
+                    k == 1 && i == 0 && j == 0  ? 256 :
+                    k == 0 && i == 1 && j == 64 ? 3 : 0;
+                CU_ASSERT(map_getTile(wideMap, k, i, j) == expected);
+                CU_ASSERT(map_isHighlighted(wideMap, k, i, j) ==
+                          (expected == 299 || expected == 3));
+            }
+        }
+    }
+    CU_ASSERT(!map_isChunkEmpty(wideMap, 1, 2, 69));
+    CU_ASSERT(map_isChunkEmpty(wideMap, 1, 2, 63));
+    map_setTile(wideMap, 1, 2, 69, 0);
+    CU_ASSERT(map_isChunkEmpty(wideMap, 1, 2, 69));
+    CU_ASSERT(map_getTile(wideMap, 1, 2, 69) == 0);
+    mapgraph_deletePath(path);
+    map_deleteMap(wideMap);
+}
+
+void test_numDirections() {
+    CU_ASSERT(map_numDirections(map->tiles[0].directionMask) == 0);
+    CU_ASSERT(map_numDirections(map->tiles[1].directionMask) == 8);
+    CU_ASSERT(map_numDirections(map->tiles[2].directionMask) == 2);
+}
+
+void test_lazyTileImages() {
+    for (unsigned int t = 0; t < map->numTiles; ++t) {
+        CU_ASSERT(map->tiles[t].image == NULL);
+    }
+}
+
+void test_heightmap() {
+    for (unsigned int i = 0; i < map->numRows; ++i) {
+        for (unsigned int j = 0; j < map->numColumns; ++j) {
+            unsigned int height = 0;
+            for (unsigned int k = 0; k < map->numLayers; ++k) {
+                if (map_getTile(map, k, i, j) != 0) height = k + 1;
+            }
+            CU_ASSERT(map_getHeight(map, i, j) == height);
+        }
+    }
+    struct Map *stackMap = map_createMap(2, 2, 4, 2);
+    map_addTile(stackMap, "flat", "art/flat.png");
+    for (unsigned int k = 0; k < 4; ++k) {
+        map_addLayer(stackMap, 0, -78.0 * k);
+    }
+    map_setTile(stackMap, 0, 0, 0, 1);
+    map_setTile(stackMap, 2, 0, 0, 1);
+    map_setTile(stackMap, 3, 0, 0, 1);
+    map_setTile(stackMap, 1, 1, 1, 1);
+    CU_ASSERT(map_getHeight(stackMap, 0, 0) == 4);
+    CU_ASSERT(map_getHeight(stackMap, 1, 1) == 2);
+    CU_ASSERT(map_getHeight(stackMap, 0, 1) == 0);
+    struct MapGraph stackGraph = mapgraph_create(stackMap);
+    struct MapCell bottom = {0, 0, 0}, middle = {0, 0, 2}, top = {0, 0, 3};
+    struct MapCell single = {1, 1, 1};
+    CU_ASSERT(stackGraph.numNodes == 3);
+    CU_ASSERT(mapgraph_hasCell(&stackGraph, &bottom));
+    CU_ASSERT(!mapgraph_hasCell(&stackGraph, &middle));
+    CU_ASSERT(mapgraph_hasCell(&stackGraph, &top));
+    CU_ASSERT(mapgraph_hasCell(&stackGraph, &single));
+    mapgraph_delete(&stackGraph);
+    map_setTile(stackMap, 3, 0, 0, 0);
+    CU_ASSERT(map_getHeight(stackMap, 0, 0) == 3);
+    map_setTile(stackMap, 2, 0, 0, 0);
+    CU_ASSERT(map_getHeight(stackMap, 0, 0) == 1);
+    map_setTile(stackMap, 0, 0, 0, 0);
+    CU_ASSERT(map_getHeight(stackMap, 0, 0) == 0);
+    map_deleteMap(stackMap);
+}
+
+void test_arena() {
+    struct Arena arena = arena_create(256);
+    char *name = arena_strdup(&arena, "flat");
+    CU_ASSERT(strcmp(name, "flat") == 0);
+    unsigned char *previous = NULL;
+    for (unsigned int i = 0; i < 100; ++i) {
+        unsigned char *memory = (unsigned char*)arena_alloc(&arena, 1 + i % 40);
+        CU_ASSERT((uintptr_t)memory % ARENA_ALIGNMENT == 0);
+        memset(memory, 0xff, 1 + i % 40);
+        CU_ASSERT(memory != previous);
+        previous = memory;
+    }
+    uint32_t *large = (uint32_t*)arena_alloc(&arena, 1000 * sizeof(uint32_t));
+    for (unsigned int i = 0; i < 1000; ++i) large[i] = i;
+    CU_ASSERT(strcmp(name, "flat") == 0);
+    CU_ASSERT(large[999] == 999);
+    arena_reset(&arena);
+    CU_ASSERT(arena.numBytes == 0);
+    CU_ASSERT(arena.blocks != NULL && arena.blocks->next == NULL);
+    CU_ASSERT(strcmp(arena_strdup(&arena, "ne"), "ne") == 0);
+    arena_delete(&arena);
+    CU_ASSERT(arena.blocks == NULL);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+    if (CU_initialize_registry() != CUE_SUCCESS )
+        return CU_get_error();
+
+    pSuite = CU_add_suite("Testing shortest paths", initSuite, cleanSuite);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing tile storage", test_tileStorage) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing tile directions",
+                    test_numDirections) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing lazy tile images",
+                    test_lazyTileImages) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing heightmap", test_heightmap) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing arena", test_arena) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing A*", test_astar) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing bidirectional BFS", test_bidirectional) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing search without graph", test_implicit) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing Dijkstra", test_dijkstra) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing Dijkstra with tile costs",
+                    test_weightedDijkstra) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing bidirectional BFS on compact graph",
+                    test_compactBidirectional) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing reused search workspace",
+                    test_searchWorkspace) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing connected components", test_components) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing path to itself", test_samePath) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing path cache", test_pathCache) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing flow field", test_flowField) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing nearest target", test_nearest) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing cells within some moves", test_range) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing A* with landmarks", test_landmarks) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing landmarks with an unreachable cell",
+                    test_landmarksUnreachable) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing sweeps from many cells", test_reach) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing hierarchical search", test_hierarchical) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    if (CU_add_test(pSuite, "Testing hierarchy update", test_hierarchyUpdate) == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -2,12 +2,17 @@
  * Module tp2
  *
  * This is the main module of the program, which generates isometric map from a
- * JSON file. Currently, three output formats are supported:
+ * JSON file. Currently, four output formats are supported:
  * - "text" format, which simply displays information about the map in a
  *   human-readable manner;
  * - "dot" format, which is the format used by Graphviz, a free and open-source
  *   software displaying graphs and networks;
- * - "png" format, which produces a PNG image of the map.
+ * - "png" format, which produces a PNG image of the map;
+ * - "flowfield" format, which writes the distance and the next move from
+ *   every cell toward the end point, as a binary grid.
+ *
+ * When a file of queries is given, the program instead answers every query
+ * of the file on the same map, one path (or distance) per line.
  *
  * The command line arguments are first retrieved and processed by the
  * `parse_args` module, then the pertinent services are called.
@@ -22,16 +27,166 @@
 #include "map.h"
 #include "map_graph.h"
 #include "map_loader.h"
+#include "map_search.h"
+#include "map_hierarchy.h"
+#include "query_batch.h"
+#include "flow_field.h"
+#include "map_landmarks.h"
+
+/**
+ * Returns the shortest path algorithm having the given name.
+ *
+ * @param name  The name of the algorithm, as given on the command line
+ * @return      The corresponding algorithm
+ */
+enum MapGraphAlgorithm algorithmFromName(const char *name) {
+    if (strcmp(name, "astar") == 0) {
+        return MAPGRAPH_ASTAR;
+    } else if (strcmp(name, "bidir") == 0) {
+        return MAPGRAPH_BIDIRECTIONAL;
+    } else if (strcmp(name, "grid") == 0) {
+        return MAPGRAPH_IMPLICIT;
+    } else if (strcmp(name, "hpa") == 0) {
+        return MAPGRAPH_HIERARCHICAL;
+    } else if (strcmp(name, "dijkstra") == 0) {
+        return MAPGRAPH_DIJKSTRA;
+    } else if (strcmp(name, "alt") == 0) {
+        return MAPGRAPH_ALT;
+    } else {
+        return MAPGRAPH_BFS;
+    }
+}
+
+/**
+ * Returns the landmarks of the given graph.
+ *
+ * If a file of landmarks is given, the landmarks are loaded from it when they
+ * were computed for the same graph. Otherwise, they are computed and saved in
+ * the file, so that they are computed only once per map.
+ *
+ * @param graph     The graph
+ * @param filename  The name of the file of landmarks ("" for no file)
+ * @return          The landmarks of the graph
+ */
+struct MapLandmarks landmarksOf(const struct MapGraph *graph,
+                                const char *filename) {
+    struct MapLandmarks landmarks;
+    if (strcmp(filename, "") == 0 ||
+        !maplandmarks_load(&landmarks, graph, filename)) {
+        landmarks = maplandmarks_create(graph, MAPLANDMARKS_COUNT);
+        if (strcmp(filename, "") != 0) {
+            maplandmarks_save(&landmarks, filename);
+        }
+    }
+    return landmarks;
+}
+
+/**
+ * Returns a shortest path between two cells, using the given algorithm.
+ *
+ * The search without graph is done on the map itself. The chunks of
+ * hierarchical search are built for this single path, and so are the
+ * landmarks of ALT search, unless they are loaded from their file.
+ *
+ * @param map        The map
+ * @param graph      The graph of the map (not used by the search without
+ *                   graph)
+ * @param start      The starting cell
+ * @param end        The ending cell
+ * @param algorithm  The algorithm used to compute the path
+ * @param arguments  The parsed arguments
+ * @return           A shortest path between two cells
+ */
+struct MapGraphPath *shortestPathOf(const struct Map *map,
+                                    const struct MapGraph *graph,
+                                    const struct MapCell *start,
+                                    const struct MapCell *end,
+                                    enum MapGraphAlgorithm algorithm,
+                                    const struct Arguments *arguments) {
+    struct MapGraphPath *path;
+    if (algorithm == MAPGRAPH_IMPLICIT) {
+        path = mapsearch_shortestPath(map, start, end);
+    } else if (algorithm == MAPGRAPH_HIERARCHICAL) {
+        struct MapHierarchy hierarchy =
+            maphierarchy_create(graph, MAPHIERARCHY_CHUNK_SIZE);
+        struct MapGraphSearch search = mapgraph_createSearch(graph);
+        path = maphierarchy_shortestPath(&hierarchy, &search, start, end);
+        mapgraph_deleteSearch(&search);
+        maphierarchy_delete(&hierarchy);
+    } else if (algorithm == MAPGRAPH_ALT) {
+        struct MapLandmarks landmarks =
+            landmarksOf(graph, arguments->landmarksFilename);
+        struct MapGraphSearch search = mapgraph_createSearch(graph);
+        path = maplandmarks_shortestPath(&landmarks, &search, start, end);
+        mapgraph_deleteSearch(&search);
+        maplandmarks_delete(&landmarks);
+    } else {
+        path = mapgraph_shortestPathWith(graph, start, end, algorithm);
+    }
+    return path;
+}
+
+/**
+ * Answers the queries of the file given in the arguments.
+ *
+ * The map and its graph are built only once for all the queries.
+ *
+ * @param arguments  The parsed arguments
+ * @return           The status of the program
+ */
+enum Error answerQueries(const struct Arguments *arguments) {
+    struct QueryBatch *batch = querybatch_load(arguments->queriesFilename);
+    if (batch == NULL) {
+        printf("Error: invalid queries file\n");
+        return TP2_ERROR_QUERIES_FORMAT;
+    }
+    struct Map *map = map_loadMapFromJSONFile(arguments->inputFilename);
+    struct MapGraph graph = mapgraph_create(map);
+    mapgraph_compact(&graph);
+    mapgraph_labelComponents(&graph);
+    enum MapGraphAlgorithm algorithm = algorithmFromName(arguments->algorithm);
+    struct MapLandmarks landmarks;
+    if (algorithm == MAPGRAPH_ALT) {
+        landmarks = landmarksOf(&graph, arguments->landmarksFilename);
+    }
+    querybatch_run(&graph, batch,
+                   algorithm,
+                   arguments->distancesOnly,
+                   arguments->numThreads,
+                   arguments->cacheSize,
+                   algorithm == MAPGRAPH_ALT ? &landmarks : NULL,
+                   arguments->outputFilename);
+    if (algorithm == MAPGRAPH_ALT) maplandmarks_delete(&landmarks);
+    querybatch_delete(batch);
+    mapgraph_delete(&graph);
+    map_deleteMap(map);
+    return TP2_OK;
+}
 
 int main(int argc, char **argv) {
     struct Arguments arguments = parseArguments(argc, argv);
-    if (arguments.status == TP2_OK && !arguments.showHelp) {
+    if (arguments.status == TP2_OK && !arguments.showHelp &&
+        strcmp(arguments.queriesFilename, "") != 0) {
+        arguments.status = answerQueries(&arguments);
+    } else if (arguments.status == TP2_OK && !arguments.showHelp) {
         struct Map *map;
         struct MapGraph graph;
         struct MapGraphPath *path;
         struct MapCell start, end;
+        enum MapGraphAlgorithm algorithm = algorithmFromName(arguments.algorithm);
+        bool withGraph = algorithm != MAPGRAPH_IMPLICIT ||
+                         strcmp(arguments.outputFormat, "dot") == 0 ||
+                         strcmp(arguments.outputFormat, "flowfield") == 0 ||
+                         strcmp(arguments.nearestTile, "") != 0 ||
+                         arguments.range >= 0;
         map = map_loadMapFromJSONFile(arguments.inputFilename);
-        graph = mapgraph_create(map);
+        if (withGraph) {
+            graph = mapgraph_create(map);
+            mapgraph_compact(&graph);
+        }
+        if (strcmp(arguments.outputFormat, "dot") == 0) {
+            mapgraph_labelComponents(&graph);
+        }
         path = NULL;
         start.layer = arguments.startLayer;
         start.row = arguments.startRow;
@@ -39,9 +194,20 @@ int main(int argc, char **argv) {
         end.layer = arguments.endLayer;
         end.row = arguments.endRow;
         end.column = arguments.endColumn;
-        if (arguments.withSolution) {
-            path = mapgraph_shortestPath(&graph, &start, &end);
+        if (arguments.withSolution && strcmp(arguments.nearestTile, "") != 0) {
+            path = mapgraph_shortestPathToNearest(&graph, &start,
+                                                  arguments.nearestTile);
             map_addSolution(map, path);
+        } else if (arguments.withSolution) {
+            path = shortestPathOf(map, &graph, &start, &end,
+                                  algorithm, &arguments);
+            map_addSolution(map, path);
+        }
+        if (arguments.range >= 0) {
+            struct MapGraphRange *range =
+                mapgraph_cellsWithin(&graph, &start, arguments.range);
+            map_addRange(map, range);
+            mapgraph_deleteRange(range);
         }
         if (strcmp(arguments.outputFormat, "text") == 0) {
             map_printMap(map, arguments.withSolution);
@@ -49,9 +215,15 @@ int main(int argc, char **argv) {
             map_toPNG(map, arguments.outputFilename);
         } else if (strcmp(arguments.outputFormat, "dot") == 0) {
             mapgraph_toDot(&graph, arguments.outputFilename);
+        } else if (strcmp(arguments.outputFormat, "flowfield") == 0) {
+            struct MapGraphSearch search = mapgraph_createSearch(&graph);
+            struct FlowField field = flowfield_create(&search, &end);
+            flowfield_toFile(&field, arguments.outputFilename);
+            flowfield_delete(&field);
+            mapgraph_deleteSearch(&search);
         }
         map_deleteMap(map);
-        mapgraph_delete(&graph);
+        if (withGraph) mapgraph_delete(&graph);
         if (arguments.withSolution) mapgraph_deletePath(path);
     }
     return arguments.status;